@@ -0,0 +1,99 @@
+/*-- AdaptiveRate.cpp------------------------------------------------------
+             This file implements AdaptiveRate member functions.
+-------------------------------------------------------------------------*/
+
+#include "AdaptiveRate.h"
+
+//--- Definition of AdaptiveRate constructor
+AdaptiveRate::AdaptiveRate(float slowest, int levels, int start)
+{
+    mySlowest = slowest;
+    myLevels = levels < 1 ? 1 : levels;
+    myLevel = start < 0 ? 0 : (start >= myLevels ? myLevels - 1 : start);
+    myCalm = 0;
+    primed = false;
+    myLast = 0;
+    myLastTime = 0;
+    mySlope = 0;
+    mySwitches = 0;
+}
+
+//--- Definition of update()
+float AdaptiveRate::update(uint64_t time_us, centi_t value,
+                           const centi_t * thresholds, int count)
+{
+    // slope over the last interval, smoothed to ignore single-reading noise;
+    // the interval is measured, as the first one after a rate change still
+    // has the length of the old rate
+    if(primed && time_us > myLastTime)
+        mySlope = (mySlope + (value - myLast) * 1e6f
+                   / (float)(time_us - myLastTime)) / 2;
+    myLast = value;
+    myLastTime = time_us;
+    primed = true;
+
+    // the distance to the closest threshold
+    centi_t distance = 0x7FFFFFFF;
+    for(int i = 0; i < count; i++)
+    {
+        centi_t d = value - thresholds[i];
+        if(d < 0)
+            d = -d;
+        if(d < distance)
+            distance = d;
+    }
+
+    int wanted;
+    if(distance <= ADAPTIVE_NEAR_BAND)
+        wanted = myLevels - 1;
+    else
+    {
+        // the rate that leaves ADAPTIVE_LOOKAHEAD readings before the
+        // closest threshold is reached at the current slope
+        float slope = mySlope < 0 ? -mySlope : mySlope;
+        float needed = ADAPTIVE_LOOKAHEAD * slope / distance;
+        wanted = 0;
+        while(wanted < myLevels - 1 && mySlowest * (1 << wanted) < needed)
+            wanted++;
+    }
+
+    if(wanted > myLevel)
+    {
+        // speed up at once
+        myLevel = wanted;
+        myCalm = 0;
+        mySwitches++;
+    }
+    else if(wanted < myLevel)
+    {
+        // slow down one level at a time, and only once it stayed calm
+        if(++myCalm >= ADAPTIVE_HOLD)
+        {
+            myLevel--;
+            myCalm = 0;
+            mySwitches++;
+        }
+    }
+    else
+        myCalm = 0;
+
+    return rate();
+}
+
+//--- Definition of rate()
+float AdaptiveRate::rate() const
+{
+    return mySlowest * (1 << myLevel);
+}
+
+//--- Definition of level()
+int AdaptiveRate::level() const
+{
+    return myLevel;
+}
+
+//--- Definition of switches()
+unsigned AdaptiveRate::switches() const
+{
+    return mySwitches;
+}
@@ -0,0 +1,90 @@
+/* AdaptiveRate.h contains the declaration of class AdaptiveRate.
+   An adaptive sampling rate policy for the temperature readings.
+   The rate is chosen among levels that double from the slowest one. It
+   slows down, one level at a time, while the temperature is flat and far
+   from every threshold, and it speeds up at once when a threshold gets
+   close or when the temperature moves fast enough to reach one within a
+   few readings.
+   Basic operations:
+     Constructor: Constructs a policy starting at a given level
+     update:      Feeds a reading and returns the rate to sample at
+     rate:        Retrieves the current rate in readings per second
+     level:       Retrieves the current level (0 is the slowest)
+     switches:    Retrieves the number of rate changes so far
+   Class Invariant:
+      1. 0 <= myLevel < myLevels
+      2. rate() == mySlowest * 2^myLevel
+-------------------------------------------------------------------------*/
+
+#ifndef ADAPTIVERATE
+#define ADAPTIVERATE
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+class AdaptiveRate
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  AdaptiveRate(float slowest, int levels, int start = 0);
+  /*-----------------------------------------------------------------------
+    Construct an AdaptiveRate object.
+
+    Precondition:  slowest > 0 readings per second; levels >= 1.
+    Postcondition: A policy with rates slowest, 2 * slowest, ...,
+        2^(levels - 1) * slowest has been constructed at level start.
+   ----------------------------------------------------------------------*/
+
+  float update(uint64_t time_us, centi_t value,
+               const centi_t * thresholds, int count);
+  /*-----------------------------------------------------------------------
+    Feed a new reading and select the rate for the next ones.
+
+    Precondition:  value was read at time_us, not before the previous
+        reading; thresholds holds count temperatures that must be detected
+        quickly.
+    Postcondition: The slope (over the time since the previous reading,
+        which after a rate change may still be of the old length) and the
+        distance to the closest threshold are updated and the new rate is
+        returned.
+   ----------------------------------------------------------------------*/
+
+  float rate() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the current rate in readings per second.
+   ----------------------------------------------------------------------*/
+
+  int level() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the current level; 0 is the slowest.
+   ----------------------------------------------------------------------*/
+
+  unsigned switches() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of rate changes since construction.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  float mySlowest;
+  int myLevels;
+  int myLevel;
+  // readings in a row that asked for a slower rate
+  int myCalm;
+  bool primed;
+  centi_t myLast;
+  uint64_t myLastTime;
+  // smoothed slope in centi-degrees per second
+  float mySlope;
+  unsigned mySwitches;
+}; // end of class declaration
+
+// Closer than this to a threshold, the fastest rate is used (centi-deg.)
+const centi_t ADAPTIVE_NEAR_BAND = 200;
+// The number of readings wanted before the closest threshold is reached
+const int ADAPTIVE_LOOKAHEAD = 8;
+// The number of calm readings in a row needed to step one level down
+const int ADAPTIVE_HOLD = 5;
+
+#endif
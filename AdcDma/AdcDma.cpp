@@ -0,0 +1,408 @@
+/*-- AdcDma.cpp------------------------------------------------------------
+             This file implements AdcDma member functions.
+-------------------------------------------------------------------------*/
+
+#include "AdcDma.h"
+
+#if defined(TARGET_STM32F4)
+#include "PeripheralPins.h"
+
+// The engine currently owning DMA2 stream 0 (used by the interrupt)
+AdcDma * AdcDma::myInstance = 0;
+
+// The rate in Hz the trigger timer counts at
+static const uint32_t TIMER_TICK = 1000000;
+#endif
+
+//--- Definition of AdcDma constructor
+AdcDma::AdcDma(PinName pin, int oversample, float rate, int outputs)
+{
+    init(&pin, 1, oversample, rate, outputs);
+}
+
+//--- Definition of scanning AdcDma constructor
+AdcDma::AdcDma(const PinName * pins, int count, int oversample, float rate,
+               int outputs)
+{
+    init(pins, count, oversample, rate, outputs);
+}
+
+//--- Definition of init()
+void AdcDma::init(const PinName * pins, int count, int oversample,
+                  float rate, int outputs)
+{
+    myCount = count > ADCDMA_MAX_CHANNELS ? ADCDMA_MAX_CHANNELS : count;
+    for(int i = 0; i < myCount; i++)
+    {
+        myPins[i] = pins[i];
+#if defined(TARGET_STM32F4)
+        myChannels[i] = STM_PIN_CHANNEL(pinmap_function(pins[i], PinMap_ADC));
+#else
+        myChannels[i] = i;
+#endif
+    }
+#if !defined(TARGET_STM32F4)
+    mySource = 0;
+    mySimHalf = 0;
+    mySimPeriod = 0;
+    mySimPulse = 0;
+    mySimTick = 1000000;
+#endif
+    myOversample = oversample;
+    myOutputs = outputs > ADCDMA_MAX_OUTPUTS ? ADCDMA_MAX_OUTPUTS : outputs;
+    // keep both halves of the block inside the buffer
+    if(2 * myOversample * myOutputs * myCount > ADCDMA_BUFFER_SIZE)
+        myOversample = ADCDMA_BUFFER_SIZE / (2 * myOutputs * myCount);
+    myRate = rate;
+    running = false;
+    isSynced = false;
+    myGuard = 20;
+    myCompare = 0;
+    myDivider = 2;
+    myHandler = 0;
+    myReady = -1;
+    myBlocks = 0;
+    myOverruns = 0;
+}
+
+//--- Definition of attach()
+void AdcDma::attach(void (*handler)(void))
+{
+    myHandler = handler;
+}
+
+//--- Definition of start()
+void AdcDma::start()
+{
+    myReady = -1;
+    myBlocks = 0;
+    myOverruns = 0;
+#if defined(TARGET_STM32F4)
+    myInstance = this;
+    __HAL_RCC_ADC1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    for(int i = 0; i < myCount; i++)
+        pinmap_pinout(myPins[i], PinMap_ADC);
+
+    // DMA2 stream 0 channel 0: ADC1->DR to myBuffer, circular, both halves
+    DMA2_Stream0->CR = 0;
+    while(DMA2_Stream0->CR & DMA_SxCR_EN);
+    DMA2->LIFCR = DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0 | DMA_LIFCR_CTEIF0
+                  | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+    DMA2_Stream0->PAR = (uint32_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uint32_t)myBuffer;
+    DMA2_Stream0->NDTR = 2 * myOversample * myOutputs * myCount;
+    DMA2_Stream0->FCR = 0;
+    DMA2_Stream0->CR = DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0
+                       | DMA_SxCR_MINC | DMA_SxCR_CIRC
+                       | DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+    NVIC_SetVector(DMA2_Stream0_IRQn, (uint32_t)&AdcDma::dma_irq);
+    NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    DMA2_Stream0->CR |= DMA_SxCR_EN;
+
+    // ADC1: 12-bit, all channels scanned on every TIM2 TRGO rising edge
+    ADC->CCR = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+    ADC1->CR2 = 0;
+    ADC1->CR1 = myCount > 1 ? ADC_CR1_SCAN : 0;
+    ADC1->SQR1 = (myCount - 1) << ADC_SQR1_L_Pos;
+    ADC1->SQR2 = 0;
+    ADC1->SQR3 = 0;
+    for(int i = 0; i < myCount; i++)
+    {
+        int channel = myChannels[i];
+        // ranks 1 - 6 are held by SQR3, ranks 7 - 12 by SQR2
+        if(i < 6)
+            ADC1->SQR3 |= channel << (5 * i);
+        else
+            ADC1->SQR2 |= channel << (5 * (i - 6));
+        // 84 cycles of sampling: (84 + 12) / 21 MHz = 4.6 us per channel
+        if(channel < 10)
+            ADC1->SMPR2 = (ADC1->SMPR2 & ~(7U << (3 * channel)))
+                          | (4U << (3 * channel));
+        else
+            ADC1->SMPR1 = (ADC1->SMPR1 & ~(7U << (3 * (channel - 10))))
+                          | (4U << (3 * (channel - 10)));
+    }
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN_0
+                | ADC_CR2_EXTSEL_1 | ADC_CR2_EXTSEL_2;
+
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+        clock *= 2;
+    TIM2->CR1 = 0;
+    if(isSynced)
+    {
+        // TIM3 channel 2 (not routed to a pin) marks the phase: in PWM
+        // mode 2 its reference rises when the counter reaches CCR2, and it
+        // is the trigger output of TIM3
+        TIM3->CCMR1 = (TIM3->CCMR1 & ~(TIM_CCMR1_OC2M | TIM_CCMR1_CC2S))
+                      | TIM_CCMR1_OC2M | TIM_CCMR1_OC2PE;
+        TIM3->CR2 = (TIM3->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_2 | TIM_CR2_MMS_0;
+        follow_pwm();
+        // TIM2 counts the marks (external clock mode 1 from ITR2, TIM3)
+        TIM2->PSC = 0;
+        TIM2->SMCR = TIM_SMCR_TS_1 | TIM_SMCR_SMS;
+    }
+    else
+    {
+        // TIM2: 1 MHz tick
+        TIM2->SMCR = 0;
+        TIM2->PSC = clock / TIMER_TICK - 1;
+    }
+    // the update event of TIM2 is routed to TRGO
+    TIM2->CR2 = TIM_CR2_MMS_1;
+    running = true;
+    reload();
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->CR1 = TIM_CR1_ARPE | TIM_CR1_CEN;
+#else
+    mySimHalf = 0;
+    running = true;
+    reload();
+#endif
+}
+
+//--- Definition of stop()
+void AdcDma::stop()
+{
+    running = false;
+#if defined(TARGET_STM32F4)
+    TIM2->CR1 = 0;
+    ADC1->CR2 = 0;
+    DMA2_Stream0->CR = 0;
+    NVIC_DisableIRQ(DMA2_Stream0_IRQn);
+#endif
+}
+
+//--- Definition of read()
+int AdcDma::read(uint16_t * out, int max)
+{
+    // take the block and clear it at once: a block completed in between
+    // would otherwise be lost without counting as an overrun
+#if defined(TARGET_STM32F4)
+    core_util_critical_section_enter();
+#endif
+    int half = myReady;
+    myReady = -1;
+#if defined(TARGET_STM32F4)
+    core_util_critical_section_exit();
+#endif
+    if(half < 0)
+        return 0;
+
+    int count = max < myOutputs ? max : myOutputs;
+    decimate(myBuffer + half * myOversample * myOutputs * myCount,
+             count * myOversample, myOversample, out, myCount);
+    return count;
+}
+
+//--- Definition of channels()
+int AdcDma::channels() const
+{
+    return myCount;
+}
+
+//--- Definition of set_output_rate()
+void AdcDma::set_output_rate(float rate)
+{
+    myRate = rate;
+    reload();
+}
+
+//--- Definition of output_rate()
+float AdcDma::output_rate() const
+{
+    uint32_t period, pulse, tick;
+    pwm_timing(period, pulse, tick);
+    if(!isSynced || period == 0)
+        return myRate;
+    return (float)tick / ((float)period * myDivider * myOversample);
+}
+
+//--- Definition of sync_to_pwm()
+void AdcDma::sync_to_pwm(bool enable, uint32_t guard_us)
+{
+    isSynced = enable;
+    myGuard = guard_us;
+    reload();
+}
+
+//--- Definition of follow_pwm()
+void AdcDma::follow_pwm()
+{
+    if(!isSynced)
+        return;
+    uint32_t period, pulse, tick;
+    pwm_timing(period, pulse, tick);
+    // a scan pass takes (84 + 12) / 21 MHz = 4.6 us per channel
+    uint32_t guard = (uint32_t)((uint64_t)myGuard * tick / 1000000);
+    uint32_t window = (uint32_t)((uint64_t)5 * myCount * tick / 1000000);
+    myCompare = pwm_phase(period, pulse, guard, window);
+#if defined(TARGET_STM32F4)
+    TIM3->CCR2 = myCompare;
+#endif
+}
+
+//--- Definition of pwm_compare()
+uint32_t AdcDma::pwm_compare() const
+{
+    return myCompare;
+}
+
+//--- Definition of pwm_phase()
+uint32_t AdcDma::pwm_phase(uint32_t period, uint32_t pulse, uint32_t guard,
+                           uint32_t window)
+{
+    if(period < 2)
+        return 0;
+    uint32_t off = pulse < period ? period - pulse : 0;
+    uint32_t phase;
+    if(pulse == 0 || off == 0)
+        // the output never switches: any phase is quiet
+        phase = period / 2;
+    else if(off >= 2 * guard + window)
+        // the middle of the settled part of the off-period
+        phase = pulse + guard + (off - 2 * guard - window) / 2;
+    else if(pulse >= 2 * guard + window)
+        // the off-period is too short: the settled part of the on-period
+        phase = guard + (pulse - 2 * guard - window) / 2;
+    else if(off >= pulse)
+        // nothing settles: as far from both edges as the off-period allows
+        phase = pulse + (off - (window < off ? window : off)) / 2;
+    else
+        phase = (pulse - (window < pulse ? window : pulse)) / 2;
+    // the compare must fall inside the period to mark it
+    if(phase < 1)
+        phase = 1;
+    if(phase > period - 1)
+        phase = period - 1;
+    return phase;
+}
+
+//--- Definition of blocks()
+unsigned AdcDma::blocks() const
+{
+    return myBlocks;
+}
+
+//--- Definition of overruns()
+unsigned AdcDma::overruns() const
+{
+    return myOverruns;
+}
+
+//--- Definition of decimate()
+void AdcDma::decimate(const uint16_t * raw, int count, int oversample,
+                      uint16_t * out, int channels)
+{
+    uint32_t sum[ADCDMA_MAX_CHANNELS];
+    for(int i = 0; i + oversample <= count; i += oversample)
+    {
+        for(int c = 0; c < channels; c++)
+            sum[c] = 0;
+        // the passes are stored one after the other, channels interleaved
+        for(int j = 0; j < oversample; j++, raw += channels)
+            for(int c = 0; c < channels; c++)
+                sum[c] += raw[c];
+        for(int c = 0; c < channels; c++)
+        {
+            // widen the 12-bit mean to 16 bits the same way read_u16() does
+            uint32_t mean = (sum[c] << 4) / oversample;
+            *out++ = (uint16_t)(mean | (mean >> 12));
+        }
+    }
+}
+
+//--- Definition of complete()
+void AdcDma::complete(int half)
+{
+    // the previous block was never read: it is lost
+    if(myReady >= 0)
+        myOverruns++;
+    myReady = half;
+    myBlocks++;
+    if(myHandler)
+        myHandler();
+}
+
+//--- Definition of reload()
+void AdcDma::reload()
+{
+    if(isSynced)
+    {
+        // whole PWM periods per conversion; TIM2 cannot divide by 1
+        uint32_t period, pulse, tick;
+        pwm_timing(period, pulse, tick);
+        float periods = period ? tick / (period * myRate * myOversample) : 2;
+        myDivider = periods < 2 ? 2 : (uint32_t)(periods + 0.5f);
+    }
+#if defined(TARGET_STM32F4)
+    if(!running)
+        return;
+    if(isSynced)
+        TIM2->ARR = myDivider - 1;
+    else
+        TIM2->ARR = (uint32_t)(TIMER_TICK / (myRate * myOversample)) - 1;
+#endif
+}
+
+//--- Definition of pwm_timing()
+void AdcDma::pwm_timing(uint32_t & period, uint32_t & pulse,
+                        uint32_t & tick_hz) const
+{
+#if defined(TARGET_STM32F4)
+    // the registers PwmOut set up for D5 (TIM3 channel 1, PWM mode 1)
+    uint32_t clock = HAL_RCC_GetPCLK1Freq();
+    if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+        clock *= 2;
+    period = TIM3->ARR + 1;
+    pulse = TIM3->CCR1;
+    tick_hz = clock / (TIM3->PSC + 1);
+#else
+    period = mySimPeriod;
+    pulse = mySimPulse;
+    tick_hz = mySimTick;
+#endif
+}
+
+#if defined(TARGET_STM32F4)
+//--- Definition of dma_irq()
+void AdcDma::dma_irq(void)
+{
+    uint32_t status = DMA2->LISR;
+    DMA2->LIFCR = DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0 | DMA_LIFCR_CTEIF0
+                  | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+    if(status & DMA_LISR_HTIF0)
+        myInstance->complete(0);
+    if(status & DMA_LISR_TCIF0)
+        myInstance->complete(1);
+}
+#else
+//--- Definition of sim_source()
+void AdcDma::sim_source(uint16_t (*source)(void))
+{
+    mySource = source;
+}
+
+//--- Definition of sim_transfer()
+void AdcDma::sim_transfer()
+{
+    if(!running || !mySource)
+        return;
+    int block = myOversample * myOutputs * myCount;
+    uint16_t * dst = myBuffer + mySimHalf * block;
+    for(int i = 0; i < block; i++)
+        dst[i] = mySource() & 0x0FFF;
+    complete(mySimHalf);
+    mySimHalf = !mySimHalf;
+}
+
+//--- Definition of sim_pwm()
+void AdcDma::sim_pwm(uint32_t period, uint32_t pulse, uint32_t tick_hz)
+{
+    mySimPeriod = period;
+    mySimPulse = pulse;
+    mySimTick = tick_hz;
+}
+#endif
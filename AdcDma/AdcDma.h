@@ -0,0 +1,277 @@
+/* AdcDma.h contains the declaration of class AdcDma.
+   A timer-triggered, DMA-driven acquisition engine for the LM35 sensor.
+   A hardware timer (TIM2) triggers every ADC conversion and the DMA
+   controller (DMA2 stream 0) stores the results in a circular buffer made
+   of two halves. The CPU is only interrupted once a half (a block) is
+   full; the block is then oversampled/decimated into readings that use
+   the same 16-bit scale as AnalogIn::read_u16().
+   Several sensors can be sampled at once: in scan mode every trigger
+   converts all the configured channels in one pass and the DMA stores
+   them next to each other, so an extra channel costs one conversion
+   (about 4.6 us) rather than another polling loop.
+   The conversions can instead be synchronized with the fan PWM (TIM3,
+   which drives D5): a spare compare channel of TIM3 marks a phase of
+   every PWM period, in the middle of the off-period away from both
+   switching edges, and TIM2 counts those marks so that a conversion
+   starts on every n-th of them. Every conversion then sees the sensor
+   at the same point of the fan current instead of at a random one.
+   Basic operations:
+     Constructor:     Constructs a stopped engine on one or more analog pins
+     attach:          Sets the function called once per completed block
+     start:           Configures the timer, ADC and DMA and starts sampling
+     stop:            Stops the timer, the ADC and the DMA
+     read:            Decimates the last completed block into readings
+     channels:        Retrieves the number of channels scanned per trigger
+     set_output_rate: Changes the number of readings produced per second
+     sync_to_pwm:     Triggers the conversions from the fan PWM timer
+     follow_pwm:      Moves the conversions to the quiet phase of the duty
+     pwm_phase:       Chooses the quiet phase of a PWM period
+   On targets other than the STM32F4 (e.g. a Linux host) the ADC and the
+   DMA are simulated: sim_source() supplies the raw conversions and
+   sim_transfer() performs one DMA half-transfer, running the exact same
+   block and decimation code as the hardware, and sim_pwm() stands for
+   the registers of the PWM timer.
+   Class Invariant:
+      1. Every block holds myOversample * myOutputs scan passes of
+         myCount conversions each (one per channel, in scan order)
+      2. 2 * block size <= ADCDMA_BUFFER_SIZE
+-------------------------------------------------------------------------*/
+
+#ifndef ADCDMA
+#define ADCDMA
+
+#if defined(TARGET_STM32F4)
+#include "mbed.h"
+#else
+#include <stdint.h>
+typedef int PinName;
+#endif
+
+// The size in conversions of the DMA buffer (both halves)
+#ifndef ADCDMA_BUFFER_SIZE
+#define ADCDMA_BUFFER_SIZE 512
+#endif
+// The maximum number of readings a single block can be decimated into
+#ifndef ADCDMA_MAX_OUTPUTS
+#define ADCDMA_MAX_OUTPUTS 8
+#endif
+// The maximum number of channels converted in one scan pass
+#ifndef ADCDMA_MAX_CHANNELS
+#define ADCDMA_MAX_CHANNELS 8
+#endif
+
+class AdcDma
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  AdcDma(PinName pin, int oversample = 64, float rate = 1.0f, int outputs = 1);
+  /*-----------------------------------------------------------------------
+    Construct an AdcDma object.
+
+    Precondition:  pin is an ADC1 capable pin. oversample * outputs fits in
+        half of ADCDMA_BUFFER_SIZE and outputs <= ADCDMA_MAX_OUTPUTS.
+    Postcondition: A stopped engine has been constructed that will produce
+        rate readings per second, each the mean of oversample conversions,
+        and interrupt the CPU once every outputs readings.
+   ----------------------------------------------------------------------*/
+
+  AdcDma(const PinName * pins, int count, int oversample = 64,
+         float rate = 1.0f, int outputs = 1);
+  /*-----------------------------------------------------------------------
+    Construct an AdcDma object scanning several pins.
+
+    Precondition:  pins holds count (<= ADCDMA_MAX_CHANNELS) ADC1 capable
+        pins. oversample * outputs * count fits in half of
+        ADCDMA_BUFFER_SIZE.
+    Postcondition: A stopped engine has been constructed that converts all
+        the pins, in the given order, on every trigger.
+   ----------------------------------------------------------------------*/
+
+  void attach(void (*handler)(void));
+  /*-----------------------------------------------------------------------
+    Set the function to be called once a block has been completed.
+
+    Precondition:  handler is safe to call from interrupt context
+        (e.g. it only sets a thread signal).
+    Postcondition: handler will be called once per completed block.
+   ----------------------------------------------------------------------*/
+
+  void start();
+  /*-----------------------------------------------------------------------
+    Start the acquisition.
+
+    Precondition:  None.
+    Postcondition: The timer triggers the ADC at rate * oversample Hz and
+        the DMA fills the buffer halves in turn.
+   ----------------------------------------------------------------------*/
+
+  void stop();
+  /*-----------------------------------------------------------------------
+    Stop the acquisition.
+
+    Precondition:  None.
+    Postcondition: No more conversions or block interrupts take place.
+   ----------------------------------------------------------------------*/
+
+  int read(uint16_t * out, int max);
+  /*-----------------------------------------------------------------------
+    Decimate the most recently completed block.
+
+    Precondition:  out has room for max * channels() readings.
+    Postcondition: Up to max readings per channel (0 - 65535, read_u16()
+        scale) are stored in out, reading i of channel c at
+        out[i * channels() + c], and their number per channel is
+        returned. 0 is returned if no new block was completed since the
+        last call.
+   ----------------------------------------------------------------------*/
+
+  int channels() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of channels converted on every trigger.
+   ----------------------------------------------------------------------*/
+
+  void set_output_rate(float rate);
+  /*-----------------------------------------------------------------------
+    Change the number of readings produced per second.
+
+    Precondition:  rate > 0.
+    Postcondition: The trigger timer is reloaded for the new rate; a
+        running acquisition keeps running.
+   ----------------------------------------------------------------------*/
+
+  float output_rate() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of readings produced per second (when synchronized
+    with the PWM, the rate actually produced, a whole number of PWM
+    periods per conversion).
+   ----------------------------------------------------------------------*/
+
+  void sync_to_pwm(bool enable, uint32_t guard_us = 20);
+  /*-----------------------------------------------------------------------
+    Trigger the conversions from the fan PWM timer.
+
+    Precondition:  Called before start(). The PWM of D5 (TIM3 channel 1)
+        has its period set and runs at least twice as fast as
+        rate * oversample conversions per second.
+    Postcondition: When enabled, start() makes every conversion start at
+        the phase chosen by follow_pwm(), at least guard_us away from the
+        switching edges, every as many PWM periods as the output rate
+        needs (at least 2).
+   ----------------------------------------------------------------------*/
+
+  void follow_pwm();
+  /*-----------------------------------------------------------------------
+    Move the conversions to the quiet phase of the current duty.
+
+    Precondition:  Called after every change of the PWM duty.
+    Postcondition: If synchronized, the conversions start at pwm_phase()
+        of the PWM period from the next period on.
+   ----------------------------------------------------------------------*/
+
+  uint32_t pwm_compare() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the phase (PWM timer ticks after the period starts) the
+    conversions start at.
+   ----------------------------------------------------------------------*/
+
+  static uint32_t pwm_phase(uint32_t period, uint32_t pulse, uint32_t guard,
+                            uint32_t window);
+  /*-----------------------------------------------------------------------
+    Choose when to start a conversion in a PWM period.
+
+    Precondition:  All in timer ticks: the output is on from 0 to pulse
+        and off from pulse to period; guard is the time the sensor needs
+        to settle after an edge; window is the duration of a conversion.
+    Postcondition: The middle of the off-period that leaves guard after
+        the falling edge and guard + window before the next rising one is
+        returned, or of the on-period if the off-period is too short, or
+        of the longer of the two if neither is long enough. The result is
+        within 1 - period - 1.
+   ----------------------------------------------------------------------*/
+
+  unsigned blocks() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of blocks completed since start().
+   ----------------------------------------------------------------------*/
+
+  unsigned overruns() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of blocks that were overwritten before read().
+   ----------------------------------------------------------------------*/
+
+  static void decimate(const uint16_t * raw, int count, int oversample,
+                       uint16_t * out, int channels = 1);
+  /*-----------------------------------------------------------------------
+    Average every oversample 12-bit conversions of each channel of raw
+    into one reading.
+
+    Precondition:  raw holds count scan passes of channels conversions
+        each and count is a multiple of oversample.
+    Postcondition: count / oversample passes of channels readings in
+        read_u16() scale are stored in out.
+   ----------------------------------------------------------------------*/
+
+#if !defined(TARGET_STM32F4)
+  void sim_source(uint16_t (*source)(void));
+  /*-----------------------------------------------------------------------
+    Set the generator of simulated 12-bit conversions (called once per
+    channel of every scan pass, in scan order).
+   ----------------------------------------------------------------------*/
+
+  void sim_transfer();
+  /*-----------------------------------------------------------------------
+    Perform one simulated DMA half-transfer.
+
+    Precondition:  start() has been called and a source has been set.
+    Postcondition: The next buffer half has been filled by the source and
+        the block has been completed exactly as the DMA interrupt would.
+   ----------------------------------------------------------------------*/
+
+  void sim_pwm(uint32_t period, uint32_t pulse, uint32_t tick_hz);
+  /*-----------------------------------------------------------------------
+    Set the simulated PWM timer: a period of period ticks of tick_hz, with
+    the output on for the first pulse ticks.
+   ----------------------------------------------------------------------*/
+#endif
+
+ private:
+  void init(const PinName * pins, int count, int oversample, float rate,
+            int outputs);
+  void complete(int half);
+  void reload();
+  void pwm_timing(uint32_t & period, uint32_t & pulse,
+                  uint32_t & tick_hz) const;
+#if defined(TARGET_STM32F4)
+  static void dma_irq(void);
+  static AdcDma * myInstance;
+#else
+  uint16_t (*mySource)(void);
+  int mySimHalf;
+  uint32_t mySimPeriod;
+  uint32_t mySimPulse;
+  uint32_t mySimTick;
+#endif
+
+  /***** Data Members *****/
+  uint16_t myBuffer[ADCDMA_BUFFER_SIZE];
+  PinName myPins[ADCDMA_MAX_CHANNELS];
+  int myChannels[ADCDMA_MAX_CHANNELS];
+  int myCount;
+  int myOversample;
+  int myOutputs;
+  float myRate;
+  bool running;
+  // synchronized with the PWM: the settling time after an edge (us), the
+  // phase of the conversions (ticks), and the PWM periods per conversion
+  bool isSynced;
+  uint32_t myGuard;
+  uint32_t myCompare;
+  uint32_t myDivider;
+  void (*myHandler)(void);
+  volatile int myReady;
+  volatile unsigned myBlocks;
+  volatile unsigned myOverruns;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,50 @@
+/*-- BandClassifier.cpp----------------------------------------------------
+             This file implements BandClassifier member functions.
+-------------------------------------------------------------------------*/
+
+#include "BandClassifier.h"
+
+//--- Definition of BandClassifier constructor
+BandClassifier::BandClassifier(centi_t hysteresis, int start)
+{
+    myHysteresis = hysteresis < 0 ? 0 : hysteresis;
+    myBand = start < 0 ? 0 : start;
+    myTransitions = 0;
+}
+
+//--- Definition of classify()
+int BandClassifier::classify(centi_t value, const centi_t * thresholds,
+                             int count)
+{
+    int band = myBand > count ? count : myBand;
+    // rise as soon as a threshold is reached
+    while(band < count && value >= thresholds[band])
+        band++;
+    // fall only once clearly below the threshold
+    while(band > 0 && value < thresholds[band - 1] - myHysteresis)
+        band--;
+    if(band != myBand)
+    {
+        myBand = band;
+        myTransitions++;
+    }
+    return myBand;
+}
+
+//--- Definition of band()
+int BandClassifier::band() const
+{
+    return myBand;
+}
+
+//--- Definition of set_hysteresis()
+void BandClassifier::set_hysteresis(centi_t hysteresis)
+{
+    myHysteresis = hysteresis < 0 ? 0 : hysteresis;
+}
+
+//--- Definition of transitions()
+unsigned BandClassifier::transitions() const
+{
+    return myTransitions;
+}
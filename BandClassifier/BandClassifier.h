@@ -0,0 +1,69 @@
+/* BandClassifier.h contains the declaration of class BandClassifier.
+   Classifies readings into the bands between ascending thresholds, with
+   hysteresis: a reading enters a higher band as soon as it reaches the
+   band's lower threshold, but only falls back once it is hysteresis
+   below it. A reading wobbling around a threshold therefore stays in
+   one band instead of switching at every reading.
+   Basic operations:
+     Constructor:    Constructs a classifier in a starting band
+     classify:       Classifies a reading and returns its band
+     band:           Retrieves the current band
+     set_hysteresis: Changes the hysteresis
+     transitions:    Retrieves the number of band changes so far
+   Class Invariant:
+      1. 0 <= myBand <= the number of thresholds of the latest classify()
+      2. myHysteresis >= 0
+-------------------------------------------------------------------------*/
+
+#ifndef BANDCLASSIFIER
+#define BANDCLASSIFIER
+
+#include "TempFixed.h"
+
+class BandClassifier
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  BandClassifier(centi_t hysteresis = 0, int start = 0);
+  /*-----------------------------------------------------------------------
+    Construct a BandClassifier object.
+
+    Precondition:  hysteresis >= 0 centi-degrees; start >= 0.
+    Postcondition: A classifier in band start has been constructed.
+   ----------------------------------------------------------------------*/
+
+  int classify(centi_t value, const centi_t * thresholds, int count);
+  /*-----------------------------------------------------------------------
+    Classify a reading.
+
+    Precondition:  thresholds holds count ascending temperatures (they
+        may change between calls).
+    Postcondition: The band of value is returned: 0 below thresholds[0],
+        i between thresholds[i - 1] and thresholds[i], count above the
+        last, with the hysteresis applied when falling.
+   ----------------------------------------------------------------------*/
+
+  int band() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the band of the latest reading.
+   ----------------------------------------------------------------------*/
+
+  void set_hysteresis(centi_t hysteresis);
+  /*-----------------------------------------------------------------------
+    Change the hysteresis (centi-degrees >= 0).
+   ----------------------------------------------------------------------*/
+
+  unsigned transitions() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of band changes since construction.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  centi_t myHysteresis;
+  int myBand;
+  unsigned myTransitions;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,127 @@
+/*-- EventHub.cpp----------------------------------------------------------
+             This file implements EventHub member functions.
+-------------------------------------------------------------------------*/
+
+#include "EventHub.h"
+
+//--- Definition of EventHub constructor
+EventHub::EventHub()
+{
+    myCount = 0;
+}
+
+//--- Definition of subscribe()
+int EventHub::subscribe(Thread & thread, int32_t signal, uint32_t topics,
+                        uint32_t interval_ms)
+{
+    core_util_critical_section_enter();
+    int id = myCount;
+    if(id < HUB_MAX_SUBSCRIBERS)
+    {
+        Subscriber & s = mySubscribers[id];
+        s.thread = &thread;
+        s.signal = signal;
+        s.topics = topics;
+        s.interval_us = interval_ms * 1000;
+        s.pending = 0;
+        s.published = 0;
+        // the first wake-up is never delayed
+        s.last = us_ticker_read() - s.interval_us;
+        s.latency = 0;
+        s.maxLatency = 0;
+        s.hold = 0;
+        s.maxHold = 0;
+        // publish() only sees the subscriber once it is complete
+        myCount = id + 1;
+    }
+    else
+        id = -1;
+    core_util_critical_section_exit();
+    return id;
+}
+
+//--- Definition of publish()
+void EventHub::publish(uint32_t topics)
+{
+    uint32_t now = us_ticker_read();
+    int count = myCount;
+    for(int i = 0; i < count; i++)
+    {
+        Subscriber & s = mySubscribers[i];
+        if((s.topics & topics) == 0)
+            continue;
+        core_util_critical_section_enter();
+        if(s.pending == 0)
+            s.published = now;
+        s.pending |= s.topics & topics;
+        core_util_critical_section_exit();
+        s.thread->signal_set(s.signal);
+    }
+}
+
+//--- Definition of wait()
+uint32_t EventHub::wait(int id)
+{
+    Subscriber & s = mySubscribers[id];
+    uint32_t topics = 0;
+    uint32_t published = 0;
+    // when the thread took the first topics
+    uint32_t seen = 0;
+    uint32_t timeout = osWaitForever;
+    while(1)
+    {
+        Thread::signal_wait(s.signal, timeout);
+        // take what was published so far
+        core_util_critical_section_enter();
+        bool first = topics == 0;
+        if(first)
+            published = s.published;
+        topics |= s.pending;
+        s.pending = 0;
+        core_util_critical_section_exit();
+        if(topics == 0)
+            continue;
+
+        uint32_t now = us_ticker_read();
+        if(first)
+            seen = now;
+        uint32_t elapsed = now - s.last;
+        if((topics & HUB_BAND) || elapsed >= s.interval_us)
+        {
+            s.last = now;
+            s.latency = seen - published;
+            if(s.latency > s.maxLatency)
+                s.maxLatency = s.latency;
+            s.hold = now - seen;
+            if(s.hold > s.maxHold)
+                s.maxHold = s.hold;
+            return topics;
+        }
+        // too early: sleep out the interval, still taking new topics
+        timeout = (s.interval_us - elapsed + 999) / 1000;
+    }
+}
+
+//--- Definition of latency()
+uint32_t EventHub::latency(int id) const
+{
+    return mySubscribers[id].latency;
+}
+
+//--- Definition of max_latency()
+uint32_t EventHub::max_latency(int id) const
+{
+    return mySubscribers[id].maxLatency;
+}
+
+//--- Definition of hold()
+uint32_t EventHub::hold(int id) const
+{
+    return mySubscribers[id].hold;
+}
+
+//--- Definition of max_hold()
+uint32_t EventHub::max_hold(int id) const
+{
+    return mySubscribers[id].maxHold;
+}
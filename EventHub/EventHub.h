@@ -0,0 +1,134 @@
+/* EventHub.h contains the declaration of class EventHub.
+   A publish/subscribe hub between the thread that produces the readings
+   and the threads that act on them. A subscriber is a thread with a
+   signal, the topics it cares about and the shortest interval it wants
+   between two wake-ups. publish() marks the topics as pending for each
+   interested subscriber and sets its signal; wait() returns the topics
+   pending since the previous wake-up, delaying it (and merging whatever
+   else is published meanwhile) until the subscriber's interval has
+   passed. HUB_BAND is never delayed. Nothing else wakes a subscriber.
+   Every wake-up records two times: the latency, from the publication of
+   the first topic it returns to the moment the subscriber's thread took
+   it (the cost of the delivery), and the hold, from then to the return
+   of wait() (the subscriber's own interval). A reading reaches the
+   subscriber after their sum.
+   Basic operations:
+     Constructor: Constructs a hub without subscribers
+     subscribe:   Registers a thread for some topics
+     publish:     Wakes the subscribers of some topics
+     wait:        Waits until one of the subscriber's topics is published
+     latency:     Retrieves the latest delivery time of one
+     max_latency: Retrieves the largest delivery time of one
+     hold:        Retrieves the latest rate-limit hold of one
+     max_hold:    Retrieves the largest rate-limit hold of one
+   Class Invariant:
+      1. 0 <= myCount <= HUB_MAX_SUBSCRIBERS
+-------------------------------------------------------------------------*/
+
+#ifndef EVENTHUB
+#define EVENTHUB
+
+#include "mbed.h"
+#include "rtos.h"
+
+// The maximum number of subscribers of a hub
+#define HUB_MAX_SUBSCRIBERS 8
+
+// Topics: a new reading, a change of the band of the thresholds, new
+// averages and forecasts
+enum HubTopic
+{
+    HUB_SAMPLE = 1,
+    HUB_BAND = 2,
+    HUB_AVERAGE = 4
+};
+
+class EventHub
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  EventHub();
+  /*-----------------------------------------------------------------------
+    Construct an EventHub object.
+
+    Precondition:  None.
+    Postcondition: A hub without subscribers has been constructed.
+   ----------------------------------------------------------------------*/
+
+  int subscribe(Thread & thread, int32_t signal, uint32_t topics,
+                uint32_t interval_ms = 0);
+  /*-----------------------------------------------------------------------
+    Register a subscriber.
+
+    Precondition:  signal is not used otherwise by thread; topics is a
+        combination of HubTopic values.
+    Postcondition: Returns the id of the subscriber to pass to wait(), or
+        -1 if the hub is full.
+   ----------------------------------------------------------------------*/
+
+  void publish(uint32_t topics);
+  /*-----------------------------------------------------------------------
+    Publish topics. Safe to call from threads and interrupts.
+
+    Precondition:  None.
+    Postcondition: The topics are pending for every subscriber interested
+        in one of them, and those subscribers have been signalled.
+   ----------------------------------------------------------------------*/
+
+  uint32_t wait(int id);
+  /*-----------------------------------------------------------------------
+    Wait for the topics of a subscriber.
+
+    Precondition:  Called by the subscriber's own thread.
+    Postcondition: Returns the topics published since the previous call,
+        no sooner than the subscriber's interval after it (unless
+        HUB_BAND is among them).
+   ----------------------------------------------------------------------*/
+
+  uint32_t latency(int id) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the us between the publication of the topics of the latest
+    wake-up of a subscriber and its thread taking them (without the hold).
+   ----------------------------------------------------------------------*/
+
+  uint32_t max_latency(int id) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the largest latency (us) of a subscriber so far.
+   ----------------------------------------------------------------------*/
+
+  uint32_t hold(int id) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the us the topics of the latest wake-up of a subscriber were
+    held by its interval once its thread had taken them.
+   ----------------------------------------------------------------------*/
+
+  uint32_t max_hold(int id) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the largest hold (us) of a subscriber so far.
+   ----------------------------------------------------------------------*/
+
+ private:
+  // A registered thread
+  struct Subscriber
+  {
+      Thread * thread;
+      int32_t signal;
+      uint32_t topics;
+      uint32_t interval_us;
+      volatile uint32_t pending;
+      // us_ticker time of the first pending publication
+      volatile uint32_t published;
+      uint32_t last;
+      uint32_t latency;
+      uint32_t maxLatency;
+      uint32_t hold;
+      uint32_t maxHold;
+  };
+
+  /***** Data Members *****/
+  Subscriber mySubscribers[HUB_MAX_SUBSCRIBERS];
+  volatile int myCount;
+}; // end of class declaration
+
+#endif
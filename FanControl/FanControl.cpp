@@ -0,0 +1,54 @@
+/*-- FanControl.cpp-------------------------------------------------------
+             This file implements the decisions of the fan control loop.
+-------------------------------------------------------------------------*/
+
+#include "FanControl.h"
+
+//--- Definition of threshold_band()
+int threshold_band(centi_t value, const centi_t * thresholds, int count)
+{
+    int band = 0;
+    while(band < count && value >= thresholds[band])
+        band++;
+    return band;
+}
+
+//--- Definition of fan_band()
+int fan_band(int band, centi_t forecast, const centi_t * thresholds,
+             int count)
+{
+    // if the trend reaches a higher band within the horizon, cool for
+    // that band already
+    int ahead = threshold_band(forecast, thresholds, count);
+    return ahead > band ? ahead : band;
+}
+
+//--- Definition of fan_duty()
+int32_t fan_duty(FanPid & pid, RelayTuner & tuner, TuneRule rule,
+                 PidGains & tuned, centi_t setpoint, centi_t measured,
+                 int band, int count, uint32_t period_ms)
+{
+    int32_t duty;
+    if(tuner.state() == TUNE_RUNNING)
+    {
+        // an auto-tune drives the fan as a relay around the setpoint
+        duty = tuner.update(measured, period_ms);
+        // once it has measured the oscillation, control with its gains
+        if(tuner.state() == TUNE_DONE)
+        {
+            tuned = tuner.gains(rule);
+            pid.set_gains(tuned);
+            pid.reset();
+        }
+    }
+    else
+        duty = pid.update(setpoint, measured, period_ms);
+    // above the top threshold, or heading there, cool at full speed
+    // whatever the controller says, and give up any auto-tune
+    if(band == count)
+    {
+        tuner.stop();
+        duty = PID_ONE;
+    }
+    return duty;
+}
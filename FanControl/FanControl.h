@@ -0,0 +1,59 @@
+/* FanControl.h contains the decisions of the fan control loop.
+   pwm() on the board and simulate_fan() on a host both call these, so a
+   simulated run goes through the same decisions as the unit: the band
+   the fan is driven for (the band of the latest reading, raised to the
+   band the forecast reaches), then the duty of the period (the relay of
+   a running auto-tune or the FanPid, the tuned gains applied once the
+   auto-tune succeeds, full speed in the top band). Nothing here depends
+   on mbed; the caller provides the locking.
+   Basic operations:
+     threshold_band: Retrieves the band of a temperature, no hysteresis
+     fan_band:       Retrieves the band the fan is driven for
+     fan_duty:       Computes the duty of one control period
+-------------------------------------------------------------------------*/
+
+#ifndef FANCONTROL
+#define FANCONTROL
+
+#include <stdint.h>
+#include "TempFixed.h"
+#include "FanPid.h"
+#include "RelayTuner.h"
+
+/*-----------------------------------------------------------------------
+  Retrieve the band of a temperature, without hysteresis.
+
+  Precondition:  thresholds holds count ascending temperatures.
+  Postcondition: 0 is returned below thresholds[0], i between
+      thresholds[i - 1] and thresholds[i], count above the last.
+ ----------------------------------------------------------------------*/
+int threshold_band(centi_t value, const centi_t * thresholds, int count);
+
+/*-----------------------------------------------------------------------
+  Retrieve the band the fan is driven for.
+
+  Precondition:  band is the band of the latest reading (with
+      hysteresis); forecast is the temperature expected within the
+      pre-arm horizon; thresholds holds count ascending temperatures.
+  Postcondition: The higher of band and the band of forecast is
+      returned: the fan cools for a band before it is reached.
+ ----------------------------------------------------------------------*/
+int fan_band(int band, centi_t forecast, const centi_t * thresholds,
+             int count);
+
+/*-----------------------------------------------------------------------
+  Compute the duty of one control period.
+
+  Precondition:  band is the result of fan_band() over count thresholds;
+      period_ms > 0 is the time since the previous period.
+  Postcondition: While tuner runs, its relay duty for measured is
+      returned, and once it succeeds tuned holds its gains for rule,
+      applied to pid (reset). Otherwise the duty of pid bringing measured
+      to setpoint is returned. In the top band (count) the tuner is
+      stopped and PID_ONE is returned.
+ ----------------------------------------------------------------------*/
+int32_t fan_duty(FanPid & pid, RelayTuner & tuner, TuneRule rule,
+                 PidGains & tuned, centi_t setpoint, centi_t measured,
+                 int band, int count, uint32_t period_ms);
+
+#endif
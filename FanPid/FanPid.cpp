@@ -0,0 +1,83 @@
+/*-- FanPid.cpp------------------------------------------------------------
+             This file implements FanPid member functions.
+-------------------------------------------------------------------------*/
+
+#include "FanPid.h"
+
+// Limits a duty to 0 - PID_ONE
+static int32_t clamp_duty(int64_t duty)
+{
+    return duty < 0 ? 0 : (duty > PID_ONE ? PID_ONE : (int32_t)duty);
+}
+
+//--- Definition of FanPid constructor
+FanPid::FanPid(const PidGains & gains, uint32_t filter_ms)
+{
+    myGains = gains;
+    myFilter = filter_ms;
+    reset();
+}
+
+//--- Definition of update()
+int32_t FanPid::update(centi_t setpoint, centi_t measured, uint32_t dt_ms)
+{
+    if(dt_ms == 0)
+        return myOutput;
+    int64_t error = measured - setpoint;
+
+    // the slope of the measurement, through a first-order low-pass
+    if(primed)
+    {
+        int64_t slope = (int64_t)(measured - myLast) * 1000 * 256 / dt_ms;
+        // a step of the measurement must not overflow the filter
+        if(slope > 0x3FFFFFFF)
+            slope = 0x3FFFFFFF;
+        if(slope < -0x3FFFFFFF)
+            slope = -0x3FFFFFFF;
+        mySlope += (int32_t)((slope - mySlope) * dt_ms
+                             / (myFilter + dt_ms));
+    }
+    myLast = measured;
+    primed = true;
+
+    // degrees are 100 centi-degrees, seconds 1000 ms
+    int64_t p = (int64_t)myGains.kp * error / 100;
+    int64_t d = (int64_t)myGains.kd * mySlope / (100 * 256);
+    int64_t integral = myIntegral
+                     + (int64_t)myGains.ki * error * dt_ms / (100 * 1000);
+
+    // integrate only if the output is not already saturated by the error
+    int64_t output = p + integral + d;
+    if(!(output > PID_ONE && error > 0) && !(output < 0 && error < 0))
+        myIntegral = clamp_duty(integral);
+    myOutput = clamp_duty(p + myIntegral + d);
+    return myOutput;
+}
+
+//--- Definition of set_gains()
+void FanPid::set_gains(const PidGains & gains)
+{
+    myGains = gains;
+}
+
+//--- Definition of gains()
+PidGains FanPid::gains() const
+{
+    return myGains;
+}
+
+//--- Definition of reset()
+void FanPid::reset()
+{
+    myIntegral = 0;
+    mySlope = 0;
+    myLast = 0;
+    primed = false;
+    myOutput = 0;
+}
+
+//--- Definition of output()
+int32_t FanPid::output() const
+{
+    return myOutput;
+}
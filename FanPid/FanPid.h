@@ -0,0 +1,99 @@
+/* FanPid.h contains the declaration of class FanPid.
+   A fixed-point PID controller turning the temperature error into a fan
+   duty cycle. Everything is computed in integers from the values passed
+   in (including the time step), so the same inputs always give the same
+   duty, on the board or on a host.
+   Units: temperatures in centi-degrees; the duty in Q16 (0 - PID_ONE is
+   0 - 100%); the gains in Q16 duty per degree (kp), per degree-second
+   (ki) and per degree per second (kd).
+   The error is measured - setpoint: the fan speeds up when it is hot.
+   Anti-windup: the integral is kept in duty units within 0 - PID_ONE and
+   stops integrating while the output is saturated by the error. The
+   derivative is taken on the measurement (no kick when the setpoint
+   moves) and low-pass filtered with a time constant.
+   Basic operations:
+     Constructor: Constructs a controller with its gains
+     update:      Computes the duty for a new measurement
+     set_gains:   Changes the gains without a bump in the output
+     gains:       Retrieves the gains
+     reset:       Forgets the integral and the derivative history
+     output:      Retrieves the latest duty
+   Class Invariant:
+      1. 0 <= myIntegral <= PID_ONE and 0 <= myOutput <= PID_ONE
+-------------------------------------------------------------------------*/
+
+#ifndef FANPID
+#define FANPID
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+// The duty of 100% (Q16)
+const int32_t PID_ONE = 65536;
+
+// The gains of a FanPid, in Q16 duty per degree (-second, per second)
+struct PidGains
+{
+    int32_t kp;
+    int32_t ki;
+    int32_t kd;
+};
+
+class FanPid
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  FanPid(const PidGains & gains, uint32_t filter_ms = 2000);
+  /*-----------------------------------------------------------------------
+    Construct a FanPid object.
+
+    Precondition:  The gains are >= 0; filter_ms is the time constant of
+        the derivative filter.
+    Postcondition: A controller with an empty integral has been
+        constructed.
+   ----------------------------------------------------------------------*/
+
+  int32_t update(centi_t setpoint, centi_t measured, uint32_t dt_ms);
+  /*-----------------------------------------------------------------------
+    Compute the duty for a new measurement.
+
+    Precondition:  dt_ms > 0 is the time since the previous update.
+    Postcondition: The integral and the filtered derivative include the
+        measurement; the duty (Q16, 0 - PID_ONE) is returned.
+   ----------------------------------------------------------------------*/
+
+  void set_gains(const PidGains & gains);
+  /*-----------------------------------------------------------------------
+    Change the gains. The integral is kept in duty units, so the output
+    does not jump because ki changed.
+   ----------------------------------------------------------------------*/
+
+  PidGains gains() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the gains in use.
+   ----------------------------------------------------------------------*/
+
+  void reset();
+  /*-----------------------------------------------------------------------
+    Forget the integral, the derivative and the previous measurement.
+   ----------------------------------------------------------------------*/
+
+  int32_t output() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the duty returned by the latest update (Q16).
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  PidGains myGains;
+  uint32_t myFilter;
+  int32_t myIntegral;
+  // filtered slope of the measurement, centi-degrees per second * 256
+  int32_t mySlope;
+  centi_t myLast;
+  bool primed;
+  int32_t myOutput;
+}; // end of class declaration
+
+#endif
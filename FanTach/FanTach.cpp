@@ -0,0 +1,133 @@
+/*-- FanTach.cpp-----------------------------------------------------------
+             This file implements FanTach member functions.
+-------------------------------------------------------------------------*/
+
+#include "FanTach.h"
+
+// Microseconds in a minute
+static const uint64_t MINUTE_US = 60000000ULL;
+
+//--- Definition of FanTach constructor
+#if defined(TARGET_STM32F4)
+FanTach::FanTach(PinName pin, int pulses, uint32_t stall_rpm,
+                 int32_t stall_duty, uint32_t stall_ms)
+    : myPin(pin)
+#else
+FanTach::FanTach(PinName, int pulses, uint32_t stall_rpm,
+                 int32_t stall_duty, uint32_t stall_ms)
+#endif
+{
+    myPulses = pulses > 0 ? pulses : 1;
+    myStallRpm = stall_rpm;
+    myStallDuty = stall_duty;
+    myStallTime = stall_ms;
+    myEdges = 0;
+    myLastEdge = 0;
+    myWindowEdges = 0;
+    myWindowEdge = 0;
+    primed = false;
+    myRpm = 0;
+    myWindowEnd = 0;
+    mySlowTime = 0;
+#if defined(TARGET_STM32F4)
+    // the output of the tachometer is open collector
+    myPin.mode(PullUp);
+    myPin.fall(this, &FanTach::edge);
+#endif
+}
+
+#if defined(TARGET_STM32F4)
+//--- Definition of edge()
+void FanTach::edge()
+{
+    stamp(us_ticker_read());
+}
+#endif
+
+//--- Definition of stamp()
+void FanTach::stamp(uint32_t time_us)
+{
+    myLastEdge = time_us;
+    myEdges++;
+}
+
+//--- Definition of update()
+uint32_t FanTach::update(uint32_t now_us, int32_t duty)
+{
+    // take the count and the stamp of the same edge
+#if defined(TARGET_STM32F4)
+    core_util_critical_section_enter();
+#endif
+    uint32_t edges = myEdges;
+    uint32_t last = myLastEdge;
+#if defined(TARGET_STM32F4)
+    core_util_critical_section_exit();
+#endif
+    if(!primed)
+    {
+        myWindowEdges = edges;
+        myWindowEdge = last;
+        myWindowEnd = now_us;
+        primed = true;
+        return myRpm;
+    }
+
+    uint32_t count = edges - myWindowEdges;
+    if(myWindowEdges == 0)
+        // no edge before this window to time the first one from
+        myRpm = 0;
+    else if(count > 0)
+    {
+        // count periods of the signal between the latest edges of the
+        // previous window and of this one
+        uint32_t span = last - myWindowEdge;
+        if(span > 0)
+            myRpm = (uint32_t)(MINUTE_US * count / ((uint64_t)span * myPulses));
+    }
+    else
+    {
+        // no edge in this window: the fan turns at most this fast
+        uint32_t since = now_us - last;
+        uint32_t bound = since ? (uint32_t)(MINUTE_US
+                                 / ((uint64_t)since * myPulses)) : myRpm;
+        if(bound < myRpm)
+            myRpm = bound;
+    }
+
+    // how long the fan has been too slow for its duty
+    uint32_t window_ms = (now_us - myWindowEnd) / 1000;
+    if(duty >= myStallDuty && myRpm < myStallRpm)
+        mySlowTime += window_ms;
+    else
+        mySlowTime = 0;
+    myWindowEdges = edges;
+    myWindowEdge = last;
+    myWindowEnd = now_us;
+    return myRpm;
+}
+
+//--- Definition of rpm()
+uint32_t FanTach::rpm() const
+{
+    return myRpm;
+}
+
+//--- Definition of stalled()
+bool FanTach::stalled() const
+{
+    return mySlowTime >= myStallTime;
+}
+
+//--- Definition of edges()
+uint32_t FanTach::edges() const
+{
+    return myEdges;
+}
+
+#if !defined(TARGET_STM32F4)
+//--- Definition of sim_edge()
+void FanTach::sim_edge(uint32_t time_us)
+{
+    stamp(time_us);
+}
+#endif
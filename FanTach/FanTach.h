@@ -0,0 +1,115 @@
+/* FanTach.h contains the declaration of class FanTach.
+   The tachometer of the fan: its open-collector output pulses a few times
+   per turn. Each falling edge interrupts the CPU, and the handler only
+   stamps the edge with the 32-bit us_ticker and counts it: two stores and
+   a timer read (HostBench/tach_bench.cpp times this on the host; the
+   interrupt entry and the dispatch of InterruptIn, not measured, come on
+   top of it on the board). The speed is computed in the thread that calls
+   update(), once per window, from the edges counted since the previous
+   window and the time between the latest edge of each window. It is
+   therefore exact to one timer tick however short the window, and a
+   window without edges gives an upper bound that falls towards 0.
+   The fan is stalled once it has turned slower than the stall speed for
+   the stall time while driven at least at the stall duty (below it, a
+   fan may legitimately stop).
+   Basic operations:
+     Constructor: Constructs a tachometer on an interrupt-capable pin
+     update:      Computes the speed of the window and checks for a stall
+     rpm:         Retrieves the speed of the latest window
+     stalled:     Tells whether the fan is stalled
+     edges:       Retrieves the number of edges counted since start
+   On targets other than the STM32F4 (e.g. a Linux host) sim_edge()
+   performs an edge with a given timestamp, running the same handler.
+   Class Invariant:
+      1. myPulses > 0
+      2. myEdges and myLastEdge are written by the edge handler only
+-------------------------------------------------------------------------*/
+
+#ifndef FANTACH
+#define FANTACH
+
+#if defined(TARGET_STM32F4)
+#include "mbed.h"
+#else
+#include <stdint.h>
+typedef int PinName;
+#endif
+
+class FanTach
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  FanTach(PinName pin, int pulses = 2, uint32_t stall_rpm = 300,
+          int32_t stall_duty = 19661, uint32_t stall_ms = 3000);
+  /*-----------------------------------------------------------------------
+    Construct a FanTach object.
+
+    Precondition:  pin can interrupt the CPU (one pin per EXTI line);
+        pulses is the number of pulses per turn; stall_duty is a duty in
+        Q16 (19661 is 30%).
+    Postcondition: The edges of pin (pulled up) are being counted.
+   ----------------------------------------------------------------------*/
+
+  uint32_t update(uint32_t now_us, int32_t duty);
+  /*-----------------------------------------------------------------------
+    End a window.
+
+    Precondition:  now_us is the current us_ticker; duty (Q16) is the duty
+        the fan was driven at during the window (0 while the output is
+        held off).
+    Postcondition: The speed of the window (rpm) is computed and returned,
+        and the stall time is advanced or cleared.
+   ----------------------------------------------------------------------*/
+
+  uint32_t rpm() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the speed (rpm) computed by the latest update().
+   ----------------------------------------------------------------------*/
+
+  bool stalled() const;
+  /*-----------------------------------------------------------------------
+    Tell whether the fan has been too slow for its duty for the stall
+    time, as of the latest update().
+   ----------------------------------------------------------------------*/
+
+  uint32_t edges() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of edges counted since construction.
+   ----------------------------------------------------------------------*/
+
+#if !defined(TARGET_STM32F4)
+  void sim_edge(uint32_t time_us);
+  /*-----------------------------------------------------------------------
+    Perform one simulated edge stamped time_us.
+   ----------------------------------------------------------------------*/
+#endif
+
+ private:
+#if defined(TARGET_STM32F4)
+  void edge();
+#endif
+  void stamp(uint32_t time_us);
+
+  /***** Data Members *****/
+#if defined(TARGET_STM32F4)
+  InterruptIn myPin;
+#endif
+  int myPulses;
+  uint32_t myStallRpm;
+  int32_t myStallDuty;
+  uint32_t myStallTime;
+  // written by the edge handler
+  volatile uint32_t myEdges;
+  volatile uint32_t myLastEdge;
+  // the edge count and the latest edge at the end of the previous window
+  uint32_t myWindowEdges;
+  uint32_t myWindowEdge;
+  bool primed;
+  uint32_t myRpm;
+  // the end of the previous window, and how long the fan has been slow
+  uint32_t myWindowEnd;
+  uint32_t mySlowTime;
+}; // end of class declaration
+
+#endif
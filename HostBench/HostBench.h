@@ -0,0 +1,90 @@
+/* HostBench.h contains the helpers shared by the host programs.
+   The programs of HostBench run the modules of the unit on a PC (g++ on
+   Linux), to check them against reference results and to time them; the
+   g++ command line of each is at the top of its file, run from the root
+   of the repository. They are not part of the firmware: .mbedignore keeps
+   this directory out of the mbed build.
+   Timings are host timings. They compare two implementations with each
+   other on the same machine; the cycles are those of the time-stamp
+   counter of the PC (0 where there is none), not Cortex-M4 cycles.
+   Basic operations:
+     bench_now_ns: Retrieves a monotonic time in ns
+     bench_cycles: Retrieves the time-stamp counter of the PC
+     bench_keep:   Keeps the compiler from dropping a computed value
+     bench_check:  Counts and reports a failed check
+     bench_exit:   Retrieves the exit status of the program
+-------------------------------------------------------------------------*/
+
+#ifndef HOSTBENCH
+#define HOSTBENCH
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// the number of failed checks so far
+static int bench_failures = 0;
+// the values passed to bench_keep()
+static volatile int64_t bench_sink = 0;
+
+/*-----------------------------------------------------------------------
+  Retrieve a monotonic time in ns.
+ ----------------------------------------------------------------------*/
+inline uint64_t bench_now_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/*-----------------------------------------------------------------------
+  Retrieve the time-stamp counter of the PC, 0 if it has none.
+ ----------------------------------------------------------------------*/
+inline uint64_t bench_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/*-----------------------------------------------------------------------
+  Keep the compiler from dropping the computation of value.
+ ----------------------------------------------------------------------*/
+inline void bench_keep(int64_t value)
+{
+    bench_sink = bench_sink + value;
+}
+
+/*-----------------------------------------------------------------------
+  Check a result.
+
+  Precondition:  what names the check.
+  Postcondition: If ok is false, the failure has been printed and
+      counted. ok is returned.
+ ----------------------------------------------------------------------*/
+inline bool bench_check(bool ok, const char * what)
+{
+    if(!ok)
+    {
+        printf("FAIL: %s\n", what);
+        bench_failures++;
+    }
+    return ok;
+}
+
+/*-----------------------------------------------------------------------
+  Retrieve the exit status of the program: 0 if every check passed.
+ ----------------------------------------------------------------------*/
+inline int bench_exit()
+{
+    printf(bench_failures == 0 ? "PASS\n" : "%d check(s) failed\n",
+           bench_failures);
+    return bench_failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,193 @@
+/* SimLcd.h contains the declaration and the implementation of class
+   SimLcd, a model of the HD44780 the TextLCD drives, wired to the pins of
+   the mbed.h stub.
+   It decodes the pins the way the controller does: RS and R/W are taken
+   when E rises, a nibble is latched when E falls (4-bit mode after the
+   function set), and on a read the busy flag is on DB7 while E is high.
+   It keeps the display RAM and the custom characters, counts the bytes
+   it received, stays busy for 40 us after each one (1.64 ms after a
+   clear or a home) and counts the timing faults of the bus: RS or R/W
+   changed while E is high, a read sampled before tDDR (1 us of virtual
+   time here) after E rose.
+   Basic operations:
+     Constructor: Constructs a powered-up controller on a set of pins
+     at:          Retrieves the character code of a cell
+     glyph:       Retrieves a row of a custom character
+     bytes:       Retrieves the number of bytes received
+     faults:      Retrieves the number of timing faults of the bus
+-------------------------------------------------------------------------*/
+
+#ifndef SIMLCD
+#define SIMLCD
+
+#include <string.h>
+#include "mbed.h"
+
+class SimLcd : public SimPins
+{
+ public:
+  // the pins of a TextLCD: rs, e, d4-d7, and rw (NC if tied to ground)
+  SimLcd(PinName rs, PinName e, PinName d4, PinName rw = NC)
+      : myRs(rs), myE(e), myD4(d4), myRw(rw)
+  {
+      memset(myLevels, 0, sizeof(myLevels));
+      memset(myDdram, ' ', sizeof(myDdram));
+      memset(myCgram, 0, sizeof(myCgram));
+      myAddress = 0;
+      inCgram = false;
+      isFourBit = false;
+      myNibble = -1;
+      myReadNibble = 0;
+      myBytes = 0;
+      myFaults = 0;
+      myBusyUntil = 0;
+      myRise = 0;
+      myRsAtRise = 0;
+      myRwAtRise = 0;
+      sim_pins() = this;
+  }
+
+  virtual void write(PinName pin, int value)
+  {
+      if(pin < 0 || pin >= PINS)
+          return;
+      int before = myLevels[pin];
+      myLevels[pin] = value;
+      // the address setup (tAS): RS and R/W hold while E is high
+      if((pin == myRs || pin == myRw) && level(myE) && before != value)
+          myFaults++;
+      if(pin != myE || before == value)
+          return;
+      if(value)
+      {
+          myRise = sim_clock();
+          myRsAtRise = level(myRs);
+          myRwAtRise = level(myRw);
+      }
+      else if(myRwAtRise)
+          myReadNibble = !myReadNibble;
+      else
+          latch();
+  }
+
+  virtual int read(PinName pin)
+  {
+      int bit = pin - myD4;
+      if(!level(myE) || !myRwAtRise || bit < 0 || bit > 3)
+          return 0;
+      // the data is valid tDDR after E rises
+      if(sim_clock() - myRise < 1)
+          myFaults++;
+      int value = myRsAtRise ? 0 : (busy() ? 0x80 : 0) | (myAddress & 0x7F);
+      int nibble = myReadNibble ? value & 0xF : value >> 4;
+      return (nibble >> bit) & 1;
+  }
+
+  // the code of the character at column, row (16x2 addressing)
+  char at(int column, int row) const
+  {
+      return myDdram[row * 0x40 + column];
+  }
+
+  // a row of the bitmap of a custom character
+  char glyph(int slot, int row) const
+  {
+      return myCgram[slot * 8 + row];
+  }
+
+  unsigned long bytes() const
+  {
+      return myBytes;
+  }
+
+  unsigned faults() const
+  {
+      return myFaults;
+  }
+
+ private:
+  static const int PINS = 64;
+
+  int level(PinName pin) const
+  {
+      return pin >= 0 && pin < PINS ? myLevels[pin] : 0;
+  }
+
+  bool busy() const
+  {
+      return (int32_t)(myBusyUntil - sim_clock()) > 0;
+  }
+
+  void latch()
+  {
+      int nibble = 0;
+      for(int i = 0; i < 4; i++)
+          nibble |= level(myD4 + i) << i;
+      if(!isFourBit)
+      {
+          // 8-bit mode: the low nibble of the bus is not wired
+          execute(nibble << 4, myRsAtRise);
+          return;
+      }
+      if(myNibble < 0)
+      {
+          myNibble = nibble;
+          return;
+      }
+      execute(myNibble << 4 | nibble, myRsAtRise);
+      myNibble = -1;
+  }
+
+  void execute(int value, int rs)
+  {
+      myBytes++;
+      myReadNibble = 0;
+      myBusyUntil = sim_clock() + 40;
+      if(rs)
+      {
+          if(inCgram)
+              myCgram[myAddress & 0x3F] = value & 0x1F;
+          else
+              myDdram[myAddress & 0x7F] = (char)value;
+          myAddress++;
+      }
+      else if(value & 0x80)
+      {
+          myAddress = value & 0x7F;
+          inCgram = false;
+      }
+      else if(value & 0x40)
+      {
+          myAddress = value & 0x3F;
+          inCgram = true;
+      }
+      else if(value & 0x20)
+          isFourBit = (value & 0x10) == 0;
+      else if(value & 0x02 || value & 0x01)
+      {
+          if(value & 0x01)
+              memset(myDdram, ' ', sizeof(myDdram));
+          myAddress = 0;
+          inCgram = false;
+          myBusyUntil = sim_clock() + 1640;
+      }
+  }
+
+  PinName myRs, myE, myD4, myRw;
+  int myLevels[PINS];
+  char myDdram[128];
+  char myCgram[64];
+  int myAddress;
+  bool inCgram;
+  bool isFourBit;
+  int myNibble;
+  int myReadNibble;
+  unsigned long myBytes;
+  unsigned myFaults;
+  uint32_t myBusyUntil;
+  uint32_t myRise;
+  int myRsAtRise;
+  int myRwAtRise;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,27 @@
+/* ThermalScenario.h contains the scenario the thermal simulations of
+   HostBench run: the settings of the unit in driver.h, except for the
+   thresholds, moved to where DEFAULT_PLANT can cross them (it settles at
+   50C with the fan off and near 31C with it at 100%).
+-------------------------------------------------------------------------*/
+
+#ifndef THERMALSCENARIO
+#define THERMALSCENARIO
+
+#include "ThermalSim.h"
+
+// The enclosure starts at the ambient temperature, powered up
+const float SCENARIO_START = 25.0f;
+// The seed of the sensor noise
+const uint32_t SCENARIO_SEED = 1;
+
+// An hour with tempMin 20C, tempMid 35C and tempMax 45C; CONTROL_PERIOD,
+// BAND_HYSTERESIS, spike_limit, PREARM_HORIZON and the sampler as in
+// driver.h; settled within 0.5C
+const SimSettings SCENARIO = {
+    2000, 3500, 4500, 250, 3600, 0.5f, 50, 300, 30, 1 / 12.0f, 6, 2
+};
+
+// the gains of fan_pid in driver.h
+const PidGains SCENARIO_GAINS = { 6554, 328, 13107 };
+
+#endif
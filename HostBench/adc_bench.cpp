@@ -0,0 +1,193 @@
+/*-- adc_bench.cpp--------------------------------------------------------
+   Runs AdcDma with its simulated ADC and DMA (sim_source(),
+   sim_transfer()) and checks the blocks it completes:
+     - the conversions of each buffer half, filled in turn, decimated into
+       the means read() returns, against a reference computed here from
+       the same conversions (the 12-bit mean widened as read_u16() does)
+     - the read_u16() scale: 0, mid-scale and full scale, the conversions
+       masked to 12 bits
+     - read() with no new block returns 0; blocks left unread are counted
+       as overruns and read() returns the latest one
+     - scan mode: 3 and 8 channels converted on every trigger, the
+       interleaved passes de-interleaved and decimated per channel, each
+       channel at its own level; the oversampling of 8 channels cut to
+       fit the buffer
+   Then times decimate() on a block of the firmware (64 conversions a
+   reading).
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -IAdcDma HostBench/adc_bench.cpp \
+           AdcDma/AdcDma.cpp -o adc_bench && ./adc_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "AdcDma.h"
+
+// the conversions of the simulated ADC, kept to check the readings
+const int MAX_CONVERSIONS = ADCDMA_BUFFER_SIZE;
+static uint16_t conversions[MAX_CONVERSIONS];
+static int converted = 0;
+static uint32_t seed = 1;
+// the value of a constant source, or -1 for the pseudo-random one
+static int level = -1;
+// scanning: the number of channels, each 500 (12-bit) above the previous
+static int scanned = 0;
+
+//--- Definition of source(): the simulated ADC
+static uint16_t source()
+{
+    uint16_t value;
+    if(level >= 0)
+        value = (uint16_t)level;
+    else if(scanned > 0)
+    {
+        // channel c at 500 * c + 200, give or take 64
+        seed = seed * 1103515245u + 12345u;
+        value = (uint16_t)(converted % scanned * 500 + 136 + (seed >> 25));
+    }
+    else
+    {
+        seed = seed * 1103515245u + 12345u;
+        // 16 bits, of which the DMA keeps the low 12
+        value = (uint16_t)(seed >> 16);
+    }
+    conversions[converted++ % MAX_CONVERSIONS] = value & 0x0FFF;
+    return value;
+}
+
+//--- Definition of expected(): the reading of channel c of pass i of
+// the conversions kept since first
+static uint16_t expected(int first, int i, int c, int oversample,
+                         int channels)
+{
+    uint32_t sum = 0;
+    for(int j = 0; j < oversample; j++)
+        sum += conversions[(first + (i * oversample + j) * channels + c)
+                           % MAX_CONVERSIONS];
+    uint32_t mean = sum * 16 / oversample;
+    return (uint16_t)(mean | (mean >> 12));
+}
+
+//--- Definition of block(): completes a block and checks the readings
+static bool block(AdcDma & adc, int oversample, int outputs)
+{
+    int first = converted;
+    adc.sim_transfer();
+    uint16_t out[ADCDMA_MAX_OUTPUTS * ADCDMA_MAX_CHANNELS];
+    int channels = adc.channels();
+    if(adc.read(out, outputs) != outputs)
+        return false;
+    for(int i = 0; i < outputs; i++)
+        for(int c = 0; c < channels; c++)
+            if(out[i * channels + c]
+               != expected(first, i, c, oversample, channels))
+                return false;
+    return true;
+}
+
+//--- Definition of single(): one channel, both halves, overruns
+static void single()
+{
+    const int OVERSAMPLE = 16;
+    const int OUTPUTS = 4;
+    AdcDma adc(0, OVERSAMPLE, 1.0f, OUTPUTS);
+    adc.sim_source(source);
+    adc.start();
+    uint16_t out[OUTPUTS];
+    bench_check(adc.read(out, OUTPUTS) == 0, "no block before a transfer");
+
+    bool ok = true;
+    // halves 0, 1, 0, 1...
+    for(int i = 0; i < 10; i++)
+        ok = ok && block(adc, OVERSAMPLE, OUTPUTS);
+    bench_check(ok, "each half is decimated into the means of its passes");
+    bench_check(adc.read(out, OUTPUTS) == 0, "a block is read only once");
+    bench_check(adc.blocks() == 10 && adc.overruns() == 0,
+                "10 blocks, read in time");
+
+    // three blocks without a read: the first two are lost
+    adc.sim_transfer();
+    adc.sim_transfer();
+    ok = block(adc, OVERSAMPLE, OUTPUTS);
+    printf("One channel: %u blocks, %u overruns\n", adc.blocks(),
+           adc.overruns());
+    bench_check(ok, "read() returns the latest block");
+    bench_check(adc.overruns() == 2, "the unread blocks are overruns");
+
+    // the read_u16() scale
+    const int levels[] = { 0, 0x800, 0xFFF, 0xFFFF };
+    const uint16_t scaled[] = { 0, 0x8008, 0xFFFF, 0xFFFF };
+    for(int i = 0; i < 4; i++)
+    {
+        level = levels[i];
+        adc.sim_transfer();
+        adc.read(out, OUTPUTS);
+        bench_check(out[0] == scaled[i] && out[OUTPUTS - 1] == scaled[i],
+                    "a constant input reads as read_u16() does");
+    }
+    level = -1;
+    adc.stop();
+}
+
+//--- Definition of scan(): count channels on every trigger
+static void scan(int count, int oversample, int outputs)
+{
+    PinName pins[ADCDMA_MAX_CHANNELS];
+    for(int i = 0; i < count; i++)
+        pins[i] = i;
+    AdcDma adc(pins, count, oversample, 1.0f, outputs);
+    adc.sim_source(source);
+    adc.start();
+    scanned = count;
+    converted = 0;
+    // the oversampling that fits both halves in the buffer
+    int fits = oversample;
+    if(2 * fits * outputs * count > ADCDMA_BUFFER_SIZE)
+        fits = ADCDMA_BUFFER_SIZE / (2 * outputs * count);
+    bool ok = adc.channels() == count;
+    for(int i = 0; i < 6; i++)
+        ok = ok && block(adc, fits, outputs);
+    bench_check(ok, "every channel of a scan is decimated on its own");
+
+    // each channel reads its own level
+    uint16_t out[ADCDMA_MAX_OUTPUTS * ADCDMA_MAX_CHANNELS];
+    adc.sim_transfer();
+    adc.read(out, outputs);
+    printf("Scan of %d channels, %d conversions a reading:", count, fits);
+    for(int c = 0; c < count; c++)
+    {
+        int mean = out[(outputs - 1) * count + c] >> 4;
+        printf(" %d", mean);
+        ok = ok && mean > 500 * c + 200 - 32 && mean < 500 * c + 200 + 32;
+    }
+    printf("\n");
+    bench_check(ok, "the passes are de-interleaved in scan order");
+    scanned = 0;
+    adc.stop();
+}
+
+int main()
+{
+    single();
+    scan(3, 16, 4);
+    // 8 channels of 64 conversions do not fit: 32
+    scan(8, 64, 1);
+
+    // decimate() over a block of the firmware: 64 conversions a reading
+    const int OVERSAMPLE = 64;
+    const int RUNS = 200000;
+    uint16_t raw[OVERSAMPLE];
+    for(int i = 0; i < OVERSAMPLE; i++)
+        raw[i] = source() & 0x0FFF;
+    uint16_t out[1];
+    uint64_t start = bench_now_ns();
+    for(int run = 0; run < RUNS; run++)
+    {
+        raw[run % OVERSAMPLE] = (uint16_t)(run & 0x0FFF);
+        AdcDma::decimate(raw, OVERSAMPLE, OVERSAMPLE, out);
+        bench_keep(out[0]);
+    }
+    printf("decimate(): %.1f ns for %d conversions on the host\n",
+           (double)(bench_now_ns() - start) / RUNS, OVERSAMPLE);
+    return bench_exit();
+}
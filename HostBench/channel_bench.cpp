@@ -0,0 +1,131 @@
+/*-- channel_bench.cpp----------------------------------------------------
+   Passes sequence numbers through the 32-slot SampleChannel of driver.h
+   from a producer thread to a consumer thread (POSIX threads, on as
+   many cores as the host gives them; the barriers of the channel are
+   __sync_synchronize() there; a side that finds the channel full or
+   empty yields, so a single core interleaves them too) and checks:
+     - 200000 numbers, the producer retrying while the channel is full:
+       every number received once, in order, and one overflow counted per
+       refused push
+     - 200000 numbers, the producer dropping them while it is full (as
+       read_temp() does): the numbers received in increasing order, none
+       twice, and the numbers received plus the overflows make 200000
+     - on one thread: 32 values fit, the 33rd is refused and counted, and
+       they come out in order
+   Build and run, from the root of the repository:
+       g++ -O2 -pthread -IHostBench -ISampleChannel \
+           HostBench/channel_bench.cpp -o channel_bench && ./channel_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "HostBench.h"
+#include "SampleChannel.h"
+
+// the numbers passed per run
+const uint32_t NUMBERS = 200000;
+
+typedef SampleChannel<uint32_t, 32> Channel;
+
+// A run: the channel, how the producer behaves and what it saw
+struct Run
+{
+    Channel channel;
+    bool retry;
+    volatile uint32_t refused;
+    volatile bool finished;
+};
+
+//--- Definition of produce(): the producer thread
+static void * produce(void * argument)
+{
+    Run * run = (Run *)argument;
+    for(uint32_t i = 0; i < NUMBERS; i++)
+    {
+        while(!run->channel.push(i))
+        {
+            run->refused++;
+            if(!run->retry)
+                break;
+            sched_yield();
+        }
+        // bursts longer than the channel: the consumer falls behind
+        if(!run->retry && i % 48 == 0)
+            sched_yield();
+    }
+    run->finished = true;
+    return 0;
+}
+
+//--- Definition of consume(): runs a producer against this thread as the
+// consumer; returns whether the numbers came in order, each once
+static bool consume(Run & run, uint32_t & received)
+{
+    pthread_t producer;
+    run.refused = 0;
+    run.finished = false;
+    pthread_create(&producer, 0, produce, &run);
+    bool ok = true;
+    uint32_t next = 0;
+    received = 0;
+    // the last numbers can be dropped: stop once the producer is done
+    // and the channel drained
+    while(true)
+    {
+        bool finished = run.finished;
+        uint32_t value;
+        if(run.channel.pop(value))
+        {
+            // in retry mode, exactly the next one
+            ok = ok && (run.retry ? value == next : value >= next);
+            next = value + 1;
+            received++;
+        }
+        else if(finished)
+            break;
+        else
+            sched_yield();
+    }
+    pthread_join(producer, 0);
+    return ok;
+}
+
+int main()
+{
+    Run run;
+    run.retry = true;
+    uint32_t received;
+    bool ok = consume(run, received);
+    printf("Retrying:  %lu received, %lu refused pushes, %lu overflows\n",
+           (unsigned long)received, (unsigned long)run.refused,
+           (unsigned long)run.channel.overflows());
+    bench_check(ok && received == NUMBERS, "every number once, in order");
+    bench_check(run.channel.overflows() == run.refused,
+                "every refused push is an overflow");
+
+    Run drop;
+    drop.retry = false;
+    ok = consume(drop, received);
+    printf("Dropping:  %lu received, %lu overflows\n",
+           (unsigned long)received, (unsigned long)drop.channel.overflows());
+    bench_check(ok, "the numbers received are in order, none twice");
+    bench_check(received + drop.channel.overflows() == NUMBERS,
+                "a number is received or counted as an overflow");
+
+    Channel channel;
+    ok = true;
+    for(uint32_t i = 0; i < 32; i++)
+        ok = ok && channel.push(i);
+    ok = ok && !channel.push(32) && channel.overflows() == 1
+         && channel.size() == 32;
+    for(uint32_t i = 0; i < 32; i++)
+    {
+        uint32_t value;
+        ok = ok && channel.pop(value) && value == i;
+    }
+    uint32_t value;
+    ok = ok && !channel.pop(value) && channel.empty();
+    bench_check(ok, "32 values fit, the 33rd is counted and dropped");
+    return bench_exit();
+}
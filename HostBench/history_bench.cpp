@@ -0,0 +1,134 @@
+/*-- history_bench.cpp----------------------------------------------------
+   Feeds the TempHistory of driver.h (60 seconds, 60 minutes, 48 hours) a
+   synthetic 3 Hz reading for 2 h, then nothing for 90 min (longer than
+   the seconds and the minutes rings, shorter than the hours one), 10 min
+   of readings again, nothing for 3 days (longer than every ring) and a
+   last minute of readings. Every 100 readings, and after each gap, every
+   bucket of every level (count, sum, min, max) is checked against a
+   reference rebuilt from all the readings kept here: the readings whose
+   period is age periods older than the period of the latest one. The
+   summaries of the serial report (the last minute, hour and two days)
+   are checked the same way at the end.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ITempHistory -ITempFixed \
+           HostBench/history_bench.cpp -o history_bench && ./history_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "HostBench.h"
+#include "TempHistory.h"
+
+typedef TempHistory<60, 60, 48> History;
+
+// every reading fed, kept for the reference
+const int MAX_READINGS = 30000;
+static uint64_t times[MAX_READINGS];
+static centi_t values[MAX_READINGS];
+static int readings = 0;
+static uint32_t seed = 1;
+
+//--- Definition of same(): whether two buckets hold the same samples
+static bool same(const HistoryBucket & a, const HistoryBucket & b)
+{
+    return a.count == b.count && a.sum == b.sum && a.min == b.min
+           && a.max == b.max;
+}
+
+//--- Definition of reference(): the buckets of a level, by age, from the
+// readings kept
+static void reference(HistoryLevel level, HistoryBucket * out, int size)
+{
+    memset(out, 0, size * sizeof(HistoryBucket));
+    if(readings == 0)
+        return;
+    uint64_t period = HISTORY_PERIOD_US[level];
+    uint64_t current = times[readings - 1] / period;
+    for(int i = readings - 1; i >= 0; i--)
+    {
+        uint64_t age = current - times[i] / period;
+        if(age >= (uint64_t)size)
+            break;
+        out[age].add(values[i]);
+    }
+}
+
+//--- Definition of matches(): whether every bucket of history matches
+// the reference
+static bool matches(const History & history)
+{
+    HistoryBucket expected[60];
+    for(int l = 0; l < HISTORY_LEVELS; l++)
+    {
+        int size = History::buckets((HistoryLevel)l);
+        reference((HistoryLevel)l, expected, size);
+        for(int age = 0; age < size; age++)
+            if(!same(history.bucket((HistoryLevel)l, age), expected[age]))
+                return false;
+    }
+    return true;
+}
+
+//--- Definition of feed(): readings at 3 Hz from start_s for seconds;
+// returns whether every check passed
+static bool feed(History & history, uint64_t start_s, int seconds)
+{
+    bool ok = true;
+    for(int i = 0; i < 3 * seconds; i++)
+    {
+        // around 25C, a few degrees of drift and noise, now and then < 0
+        seed = seed * 1103515245u + 12345u;
+        centi_t value = 2500 + (centi_t)((seed >> 8) % 4001) - 2000
+                        + (i / 3000 % 2 ? 300 : -300);
+        if((seed >> 4) % 997 == 0)
+            value = -150;
+        uint64_t time = start_s * 1000000ULL + i * 1000000ULL / 3;
+        history.add(time, value);
+        times[readings] = time;
+        values[readings++] = value;
+        if(readings % 100 == 0)
+            ok = ok && matches(history);
+    }
+    return ok && matches(history);
+}
+
+int main()
+{
+    History history;
+    bool ok = feed(history, 0, 7200);
+    printf("2 h at 3 Hz: %d readings\n", readings);
+    bench_check(ok, "every bucket holds the readings of its period");
+
+    // 90 min without readings: the seconds and minutes are emptied
+    ok = feed(history, 7200 + 5400, 600);
+    bench_check(history.bucket(HISTORY_MINUTES, 59).count == 0,
+                "a gap leaves empty minutes");
+    bench_check(ok, "the buckets are right after a 90 min gap");
+
+    // 3 days without readings: every level starts over
+    uint64_t later = 7200 + 5400 + 600 + 3 * 86400;
+    HistoryBucket before = history.summary(HISTORY_HOURS, 48);
+    ok = feed(history, later, 60);
+    HistoryBucket days = history.summary(HISTORY_HOURS, 48);
+    printf("After a gap of 3 days: %lu readings in the last 48 h,"
+           " %lu before it\n", (unsigned long)days.count,
+           (unsigned long)before.count);
+    bench_check(ok && days.count == 180, "a gap of 3 days empties all");
+
+    // the summaries of the serial report
+    HistoryBucket expected[60], total;
+    const HistoryLevel levels[] = { HISTORY_SECONDS, HISTORY_MINUTES,
+                                    HISTORY_HOURS };
+    const int counts[] = { 60, 60, 48 };
+    ok = true;
+    for(int i = 0; i < 3; i++)
+    {
+        reference(levels[i], expected, counts[i]);
+        memset(&total, 0, sizeof(total));
+        for(int age = 0; age < counts[i]; age++)
+            total.add(expected[age]);
+        ok = ok && same(history.summary(levels[i], counts[i]), total);
+    }
+    bench_check(ok, "the minute, hour and two days summaries are right");
+    return bench_exit();
+}
@@ -0,0 +1,222 @@
+/*-- hub_latency.cpp------------------------------------------------------
+   Simulates an hour of readings and measures, for every output, the time
+   from each reading to the first wake-up of the output that takes it (or
+   a newer one), before and after the EventHub:
+     before: the original threads, each waking on its own Thread::wait()
+             timer (3000 ms; 1500 ms for the UART), over every phase of
+             the timer against the readings
+     after:  the leds, the UART and the LCD woken by the EventHub (the
+             real EventHub.cpp, under the virtual-time stubs of
+             HostBench/stub) with the intervals of main(); the fan by its
+             CONTROL_PERIOD loop
+   The readings come every 3 s (the starting rate of the sampler in
+   driver.h), then every 375 ms (its fastest rate, near a threshold); 1 in
+   BAND_ODDS crosses a threshold (HUB_BAND). The leds act on the band
+   changes only, the other outputs on every reading; a wake-up with
+   nothing new to act on is idle. The time through the hub is the
+   delivery (0 here: the scheduler is not simulated; the board prints it
+   in its UART report) plus the hold of the subscriber's interval, which
+   is printed as well.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench/stub -IHostBench -IEventHub \
+           HostBench/hub_latency.cpp EventHub/EventHub.cpp \
+           -o hub_latency && ./hub_latency
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "EventHub.h"
+
+// the simulated time, us
+const uint32_t RUN_US = 3600000000u;
+// the periods of the readings, us
+const uint32_t SAMPLE_US[] = { 3000000, 375000 };
+// 1 reading in BAND_ODDS changes band
+const uint32_t BAND_ODDS = 8;
+// the step between the phases of the polling timers, us
+const uint32_t PHASE_STEP_US = 10000;
+// the most readings of a run
+const int READINGS = RUN_US / 375000;
+
+// A reading of the run
+struct Reading
+{
+    uint32_t time_us;
+    bool band;
+};
+static Reading readings[READINGS];
+static int count = 0;
+
+// The time from the readings to an output, over a run
+struct Stats
+{
+    uint64_t total;
+    uint32_t worst;
+    unsigned count;
+    unsigned wakeups;
+    unsigned idle;
+    uint64_t hold;
+    // the runs the counts add up (one per phase of a timer)
+    unsigned runs;
+
+    Stats() : total(0), worst(0), count(0), wakeups(0), idle(0),
+              hold(0), runs(1) {}
+    void add(uint32_t latency)
+    {
+        total += latency;
+        if(latency > worst)
+            worst = latency;
+        count++;
+    }
+};
+
+// An output thread and how it is woken before and after
+struct Output
+{
+    const char * name;
+    // true if it acts on the band changes only
+    bool bands;
+    // the Thread::wait() of the original thread, ms
+    uint32_t poll_ms;
+    // the hub topics and interval (ms) it subscribes with; no topics:
+    // it polls every interval instead
+    uint32_t topics;
+    uint32_t interval_ms;
+};
+
+const Output outputs[] = {
+    { "leds", true, 3000, HUB_BAND, 0 },
+    { "uart", false, 1500, HUB_SAMPLE | HUB_BAND, 1500 },
+    { "lcd", false, 3000, HUB_SAMPLE | HUB_AVERAGE, 300 },
+    { "fan", false, 3000, 0, 250 }
+};
+
+//--- Definition of observe(): the output wakes at now
+static void observe(const Output & output, Stats & stats, int & next,
+                    uint32_t now)
+{
+    int first = next;
+    while(next < count && readings[next].time_us <= now)
+        next++;
+    stats.wakeups++;
+    // the readings published since the previous wake-up reach the output
+    unsigned acted = stats.count;
+    for(int i = first; i < next; i++)
+        if(!output.bands || readings[i].band)
+            stats.add(now - readings[i].time_us);
+    if(stats.count == acted)
+        stats.idle++;
+}
+
+//--- Definition of poll(): a thread waking every period_ms
+static Stats poll(const Output & output, uint32_t period_ms)
+{
+    Stats stats;
+    uint32_t period = period_ms * 1000;
+    stats.runs = period / PHASE_STEP_US;
+    for(uint32_t phase = 0; phase < period; phase += PHASE_STEP_US)
+    {
+        int next = 0;
+        for(uint64_t now = phase; now < RUN_US; now += period)
+            observe(output, stats, next, (uint32_t)now);
+    }
+    return stats;
+}
+
+// The publications of read_temp and of the averaging thread
+class Publications : public SimEvents
+{
+ public:
+  Publications(EventHub & hub) : myHub(hub), myNext(0) {}
+  virtual bool next(uint32_t & time_us)
+  {
+      if(myNext >= count)
+          return false;
+      time_us = readings[myNext].time_us;
+      return true;
+  }
+  virtual void run()
+  {
+      myHub.publish(HUB_SAMPLE | HUB_AVERAGE
+                    | (readings[myNext].band ? HUB_BAND : 0));
+      myNext++;
+  }
+ private:
+  EventHub & myHub;
+  int myNext;
+};
+
+//--- Definition of subscribe(): a thread woken by the hub
+static Stats subscribe(const Output & output)
+{
+    Stats stats;
+    sim_clock() = 0;
+    EventHub hub;
+    Thread thread;
+    Publications publications(hub);
+    sim_running() = &thread;
+    sim_events() = &publications;
+    int id = hub.subscribe(thread, 0x2, output.topics, output.interval_ms);
+    int next = 0;
+    try
+    {
+        while(true)
+        {
+            hub.wait(id);
+            observe(output, stats, next, us_ticker_read());
+            stats.hold += hub.hold(id);
+            bench_check(hub.latency(id) == 0, "no delivery time simulated");
+        }
+    }
+    catch(SimOver &)
+    {
+    }
+    return stats;
+}
+
+//--- Definition of print()
+static void print(const char * when, const Stats & stats, bool hub)
+{
+    printf("  %-7s mean %7.1f ms  max %6.1f ms", when,
+           stats.total / 1000.0 / stats.count, stats.worst / 1000.0);
+    if(hub)
+        printf("  hold %6.1f ms", stats.hold / 1000.0 / stats.wakeups);
+    else
+        printf("                ");
+    printf("  %5u wake-ups, %3.0f%% idle\n", stats.wakeups / stats.runs,
+           100.0 * stats.idle / stats.wakeups);
+}
+
+int main()
+{
+    for(unsigned r = 0; r < sizeof(SAMPLE_US) / sizeof(SAMPLE_US[0]); r++)
+    {
+        uint32_t seed = 1;
+        count = RUN_US / SAMPLE_US[r];
+        for(int i = 0; i < count; i++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            readings[i].time_us = i * SAMPLE_US[r];
+            readings[i].band = (seed >> 16) % BAND_ODDS == 0;
+        }
+        printf("Readings every %u ms, %d in an hour\n",
+               (unsigned)(SAMPLE_US[r] / 1000), count);
+
+        for(unsigned i = 0; i < sizeof(outputs) / sizeof(outputs[0]); i++)
+        {
+            const Output & output = outputs[i];
+            Stats before = poll(output, output.poll_ms);
+            bool hub = output.topics != 0;
+            Stats after = hub ? subscribe(output)
+                              : poll(output, output.interval_ms);
+            printf(" %s (%s)\n", output.name,
+                   output.bands ? "band changes" : "every reading");
+            print("before:", before, false);
+            print("after:", after, hub);
+            bench_check(after.total / after.count
+                        <= before.total / before.count,
+                        "the mean latency does not grow");
+        }
+    }
+    return bench_exit();
+}
@@ -0,0 +1,209 @@
+/*-- lcd_bus.cpp----------------------------------------------------------
+   Drives TextLCD in its blocking mode into the HD44780 model of SimLcd.h
+   (virtual time: the delays and the busy waits of the driver move the
+   clock) and checks, with R/W tied to ground (the fixed delays of the
+   board) and with R/W wired (the busy flag polled):
+     - the panel shows what was written, frame after frame
+     - no timing fault of the bus: RS and R/W set before E rises, the
+       busy flag sampled tDDR after E rose
+     - the busy flag stays polled (no timeout)
+   and prints the bus time of a frame of display_temp() in both modes.
+   Then prints the bus bytes and time of typical screens with the fixed
+   delays of the board (160 us a byte, 1.64 ms more for a clear), before
+   and after the shadow of the TextLCD. Before is counted the way the
+   driver without the shadow sent them: an address command and the
+   character for every character written, the clear command for cls().
+   After is what the panel received from this driver.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench/stub -IHostBench -ITextLCD \
+           HostBench/lcd_bus.cpp TextLCD/TextLCD.cpp -o lcd_bus && ./lcd_bus
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "SimLcd.h"
+#include "TextLCD.h"
+
+// the pins: rs, e, d4-d7, rw
+const PinName RS = 1, E = 2, D4 = 3, RW = 7;
+
+//--- Definition of shows(): whether the panel shows two lines
+static bool shows(const SimLcd & panel, const char * first,
+                  const char * second)
+{
+    for(int i = 0; i < 16; i++)
+        if(panel.at(i, 0) != first[i] || panel.at(i, 1) != second[i])
+            return false;
+    return true;
+}
+
+//--- Definition of run(): frames of display_temp() with or without R/W
+static void run(bool wired)
+{
+    SimLcd panel(RS, E, D4, wired ? RW : NC);
+    TextLCD lcd(RS, E, D4, D4 + 1, D4 + 2, D4 + 3, TextLCD::LCD16x2,
+                wired ? RW : NC);
+    bool ok = true;
+    uint32_t total = 0;
+    const int FRAMES = 50;
+    for(int frame = 0; frame < FRAMES; frame++)
+    {
+        char first[17], second[17];
+        snprintf(first, sizeof(first), "T: %3dC TA: %3dC", 30 + frame / 10,
+                 30 + frame / 12);
+        snprintf(second, sizeof(second), "Max in %6lds  ",
+                 (long)(900 - frame * 3));
+        uint32_t start = sim_clock();
+        lcd.locate(0, 0);
+        lcd.printf("%s", first);
+        lcd.locate(0, 1);
+        lcd.printf("%s", second);
+        total += sim_clock() - start;
+        ok = ok && shows(panel, first, second);
+    }
+    printf("  R/W %s: %lu bytes, %.2f ms a frame, %u timing faults\n",
+           wired ? "wired, busy flag" : "tied low, delays",
+           panel.bytes(), total / 1000.0 / FRAMES, panel.faults());
+    bench_check(ok, "the panel shows every frame");
+    bench_check(panel.faults() == 0, "RS and R/W settle before E rises");
+    bench_check(lcd.polling() == wired, "the busy flag is polled if wired");
+    sim_pins() = 0;
+}
+
+// The bytes and the bus time of a screen, before and after the shadow
+struct Cost
+{
+    unsigned long before;
+    uint32_t before_us;
+    unsigned long after;
+    uint32_t after_us;
+};
+
+// A screen written to the TextLCD, from a time on
+class Screen
+{
+ public:
+  Screen(TextLCD & lcd) : myLcd(lcd)
+  {
+      memset(&myCost, 0, sizeof(myCost));
+      myBytes = lcd.bytes();
+      myStart = sim_clock();
+  }
+  void cls()
+  {
+      myLcd.cls();
+      myCost.before++;
+      myCost.before_us += 160 + 1640;
+  }
+  void line(int row, const char * text)
+  {
+      myLcd.locate(0, row);
+      myLcd.printf("%s", text);
+      int length = (int)strlen(text);
+      myCost.before += 2 * length;
+      myCost.before_us += 2 * 160 * length;
+  }
+  Cost cost()
+  {
+      myCost.after = myLcd.bytes() - myBytes;
+      myCost.after_us = sim_clock() - myStart;
+      return myCost;
+  }
+ private:
+  TextLCD & myLcd;
+  Cost myCost;
+  unsigned long myBytes;
+  uint32_t myStart;
+};
+
+//--- Definition of print()
+static void print(const char * name, const Cost & cost)
+{
+    printf("  %-34s %3lu bytes %5.1f ms  %3lu bytes %5.1f ms\n", name,
+           cost.before, cost.before_us / 1000.0, cost.after,
+           cost.after_us / 1000.0);
+}
+
+//--- Definition of table(): the typical screens
+static void table()
+{
+    SimLcd panel(RS, E, D4);
+    TextLCD lcd(RS, E, D4, D4 + 1, D4 + 2, D4 + 3, TextLCD::LCD16x2);
+    printf("%-36s %17s  %17s\n", "Screen (R/W tied low)", "before",
+           "after");
+
+    // display_temp(): the first frame after a clear
+    Screen first(lcd);
+    first.cls();
+    first.line(0, "T:  30C TA:  29C");
+    first.line(1, "Max in    900s  ");
+    print("display_temp, first frame", first.cost());
+
+    // the next frames: the countdown, now and then a temperature
+    unsigned long least = ~0UL, most = 0;
+    uint32_t least_us = ~0u, most_us = 0;
+    Cost before = { 0, 0, 0, 0 };
+    char text[17];
+    for(int frame = 1; frame <= 100; frame++)
+    {
+        Screen next(lcd);
+        snprintf(text, sizeof(text), "T: %3dC TA: %3dC", 30 + frame / 10,
+                 29 + frame / 12);
+        next.line(0, text);
+        snprintf(text, sizeof(text), "Max in %6lds  ",
+                 (long)(900 - frame * 3));
+        next.line(1, text);
+        Cost cost = next.cost();
+        before = cost;
+        if(cost.after < least)
+            least = cost.after, least_us = cost.after_us;
+        if(cost.after > most)
+            most = cost.after, most_us = cost.after_us;
+    }
+    printf("  %-34s %3lu bytes %5.1f ms  %lu-%lu bytes %.1f-%.1f ms\n",
+           "display_temp, next 100 frames", before.before,
+           before.before_us / 1000.0, least, most, least_us / 1000.0,
+           most_us / 1000.0);
+
+    // the same frame again
+    Screen same(lcd);
+    same.line(0, text);
+    same.line(1, text);
+    same.cost();
+    Screen again(lcd);
+    again.line(0, text);
+    again.line(1, text);
+    print("display_temp, unchanged frame", again.cost());
+
+    // emergency(): the flashing line and the countdown, every 200 ms
+    Screen alert(lcd);
+    alert.line(0, "!! EMERGENCY !! ");
+    alert.line(1, "Back In: 10     ");
+    alert.cost();
+    Screen tick(lcd);
+    tick.line(0, "   EMERGENCY    ");
+    tick.line(1, "Back In:  9     ");
+    print("emergency tick", tick.cost());
+
+    // the clear of a short message (the settings of the keyboard)
+    Screen done(lcd);
+    done.cls();
+    done.line(0, "      DONE!     ");
+    done.cost();
+    Screen clear(lcd);
+    clear.cls();
+    print("cls of DONE!", clear.cost());
+
+    bench_check(shows(panel, "                ", "                "),
+                "the panel is blank after the clear");
+    sim_pins() = 0;
+}
+
+int main()
+{
+    printf("50 frames of display_temp()\n");
+    run(false);
+    run(true);
+    table();
+    return bench_exit();
+}
@@ -0,0 +1,150 @@
+/*-- lcd_widgets.cpp------------------------------------------------------
+   Draws the status screen of display_temp() (the temperatures on the
+   first line; the sparkline of the minutes, a space and the bar of the
+   duty on the second) through LcdLayer, LcdCompositor and TextLCD into
+   the HD44780 model of SimLcd.h, and checks what the panel shows: the
+   first line intact, every cell of the graphs the character or the
+   custom character (and its bitmap) it should be. The sparkline uses
+   all 7 of its glyphs and the bar 1, so every slot of the panel is
+   taken, codes 0-7 (10 the newline among them); then the graphs change
+   and the screen is checked again.
+   Then prints the bus bytes of the second line over 10 simulated minutes
+   of a reading a second, the temperature rising from 30 C to 40 C: the
+   graphs (the minutes of a TempHistory and a duty following the
+   temperature) against the countdown to a tempMax of 45 C they replace.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench/stub -IHostBench -ITextLCD -ILcdCompositor \
+           -ILcdWidgets -ITempFixed -ITempHistory \
+           HostBench/lcd_widgets.cpp TextLCD/TextLCD.cpp \
+           LcdCompositor/LcdCompositor.cpp LcdWidgets/LcdWidgets.cpp \
+           -o lcd_widgets && ./lcd_widgets
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "SimLcd.h"
+#include "LcdWidgets.h"
+
+// the sparkline and the bar of display_temp() (SPARK_CELLS, DUTY_CELLS)
+const int SPARK_CELLS = 10;
+const int DUTY_CELLS = 5;
+// the character of the ROM lighting every pixel of a cell
+const char FULL_CELL = (char)0xFF;
+
+//--- Definition of expect(): checks the cell at column of the second line
+// against a character, or a bitmap of lit rows (top) and columns (left)
+static bool expect(const SimLcd & panel, int column, char code, int rows,
+                   int columns)
+{
+    char shown = panel.at(column, 1);
+    if(code != 0)
+        return shown == code;
+    if(shown < 0 || shown >= LCD_GLYPHS)
+        return false;
+    char lit = (0x1F << (BAR_PIXELS - columns)) & 0x1F;
+    for(int row = 0; row < 8; row++)
+        if(panel.glyph(shown, row) != (row >= 8 - rows ? lit : 0))
+            return false;
+    return true;
+}
+
+//--- Definition of frame(): draws the screen, with the minute means
+// rising by step from the first, and checks it
+static void frame(SimLcd & panel, LcdLayer & status, LcdCompositor & screen,
+                  centi_t step, float duty)
+{
+    HistoryBucket minutes[SPARK_CELLS];
+    memset(minutes, 0, sizeof(minutes));
+    // the oldest two minutes are empty, the others one level apart
+    for(int i = 2; i < SPARK_CELLS; i++)
+        minutes[i].add(3000 + (i - 2) * step);
+    status.locate(0, 0);
+    status.printf("T: %3dC TA: %3dC", 31, 30);
+    status.locate(0, 1);
+    sparkline(status, minutes, SPARK_CELLS);
+    status.putc(' ');
+    bar(status, duty, DUTY_CELLS);
+    screen.render();
+
+    char line[17];
+    for(int i = 0; i < 16; i++)
+        line[i] = panel.at(i, 0);
+    line[16] = 0;
+    printf("line 1: \"%s\"  line 2:", line);
+    for(int i = 0; i < 16; i++)
+        printf(" %02x", panel.at(i, 1) & 0xFF);
+    printf("\n");
+    bench_check(strcmp(line, "T:  31C TA:  30C") == 0,
+                "the first line is intact");
+
+    bool ok = expect(panel, 0, ' ', 0, 0) && expect(panel, 1, ' ', 0, 0);
+    // levels 1 to 7 are glyphs, 8 the full block
+    for(int level = 1; level <= SPARK_LEVELS; level++)
+        ok = ok && expect(panel, 1 + level,
+                          level == SPARK_LEVELS ? FULL_CELL : 0, level, 5);
+    bench_check(ok, "the sparkline shows 8 levels");
+    ok = expect(panel, SPARK_CELLS, ' ', 0, 0);
+    int pixels = (int)(duty * DUTY_CELLS * BAR_PIXELS + 0.5f);
+    for(int i = 0; i < DUTY_CELLS; i++, pixels -= BAR_PIXELS)
+        ok = ok && expect(panel, SPARK_CELLS + 1 + i,
+                          pixels >= BAR_PIXELS ? FULL_CELL
+                          : pixels <= 0 ? ' ' : 0, 8, pixels);
+    bench_check(ok, "the bar shows the duty");
+}
+
+//--- Definition of traffic(): the bus bytes of the second line over 10
+// minutes, the graphs or the countdown
+static unsigned long traffic(bool graphs)
+{
+    SimLcd panel(1, 2, 3);
+    TextLCD lcd(1, 2, 3, 4, 5, 6, TextLCD::LCD16x2);
+    LcdCompositor screen(lcd);
+    LcdLayer status(screen, LAYER_STATUS, true);
+    TempHistory<60, 60, 48> history;
+    uint32_t seed = 1;
+    unsigned long start = panel.bytes();
+    for(int second = 0; second < 600; second++)
+    {
+        // 30 C to 40 C, give or take 0.2 C
+        seed = seed * 1103515245u + 12345u;
+        centi_t temp = 3000 + second * 1000 / 600 + (int)(seed >> 27) - 16;
+        history.add((uint64_t)second * 1000000, temp);
+        status.locate(0, 1);
+        if(graphs)
+        {
+            HistoryBucket minutes[SPARK_CELLS];
+            for(int i = 0; i < SPARK_CELLS; i++)
+                minutes[i] = history.bucket(HISTORY_MINUTES,
+                                            SPARK_CELLS - 1 - i);
+            sparkline(status, minutes, SPARK_CELLS);
+            status.putc(' ');
+            bar(status, (temp - 2500) / 2000.0f, DUTY_CELLS);
+        }
+        else
+            // 1 C a minute towards 45 C
+            status.printf("Max in %6lds  ", (long)((4500 - temp) * 60 / 100));
+        screen.render();
+    }
+    sim_pins() = 0;
+    return panel.bytes() - start;
+}
+
+int main()
+{
+    SimLcd panel(1, 2, 3);
+    TextLCD lcd(1, 2, 3, 4, 5, 6, TextLCD::LCD16x2);
+    LcdCompositor screen(lcd);
+    LcdLayer status(screen, LAYER_STATUS, true);
+
+    frame(panel, status, screen, 100, 0.5f);
+    // the slots change hands: a steeper trend and another duty
+    frame(panel, status, screen, 250, 0.28f);
+    sim_pins() = 0;
+
+    unsigned long graphs = traffic(true);
+    unsigned long countdown = traffic(false);
+    printf("10 minutes of the second line: graphs %lu bus bytes, countdown"
+           " %lu\n", graphs, countdown);
+    bench_check(graphs > 0 && countdown > 0, "both lines reach the panel");
+    return bench_exit();
+}
@@ -0,0 +1,127 @@
+/*-- median_bench.cpp-----------------------------------------------------
+   Checks MedianFilter against a brute-force median (the window copied
+   and sorted at every reading) for windows of 5 to 255 readings, in both
+   modes, and compares the time per reading of the two.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -IMedianFilter HostBench/median_bench.cpp \
+           -o median_bench && ./median_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "MedianFilter.h"
+
+// the readings checked and timed per window size
+const int READINGS = 200000;
+// the spike limit of the SPIKE_REJECT checks, centi-degrees
+const int32_t LIMIT = 300;
+
+// A reproducible stream of readings around 25C with 1% spikes
+class Readings
+{
+ public:
+  Readings() : mySeed(1) {}
+  int32_t next()
+  {
+      mySeed = mySeed * 1103515245u + 12345u;
+      uint32_t r = mySeed >> 8;
+      int32_t value = 2500 + (int32_t)(r % 200) - 100;
+      if(r % 100 == 0)
+          value += (r & 0x100) ? 4000 : -4000;
+      return value;
+  }
+ private:
+  uint32_t mySeed;
+};
+
+// The window re-sorted at every reading
+template <int N>
+class BruteMedian
+{
+ public:
+  BruteMedian() : myIndex(0), myCount(0) {}
+  int32_t filter(int32_t value)
+  {
+      myData[myIndex] = value;
+      myIndex = (myIndex + 1) % N;
+      if(myCount < N)
+          myCount++;
+      // an insertion sort of a copy of the window
+      int32_t sorted[N];
+      for(int i = 0; i < myCount; i++)
+      {
+          int j = i;
+          for(; j > 0 && sorted[j - 1] > myData[i]; j--)
+              sorted[j] = sorted[j - 1];
+          sorted[j] = myData[i];
+      }
+      int32_t middle = sorted[myCount / 2];
+      if((myCount & 1) == 0)
+          middle = (middle + sorted[myCount / 2 - 1]) / 2;
+      return middle;
+  }
+ private:
+  int32_t myData[N];
+  int myIndex;
+  int myCount;
+};
+
+//--- Definition of check(): both modes against the brute force
+template <int N>
+bool check()
+{
+    MedianFilter<int32_t, N> median(MEDIAN_OUTPUT);
+    MedianFilter<int32_t, N> spikes(SPIKE_REJECT, LIMIT);
+    BruteMedian<N> brute;
+    Readings readings;
+    for(int i = 0; i < READINGS; i++)
+    {
+        int32_t value = readings.next();
+        int32_t expected = brute.filter(value);
+        int32_t deviation = value < expected ? expected - value
+                                             : value - expected;
+        int32_t passed = deviation > LIMIT ? expected : value;
+        if(median.filter(value) != expected
+           || spikes.filter(value) != passed)
+            return false;
+    }
+    return true;
+}
+
+//--- Definition of time_filter(): ns per reading
+template <class Filter>
+double time_filter(Filter & filter)
+{
+    Readings readings;
+    uint64_t start = bench_now_ns();
+    for(int i = 0; i < READINGS; i++)
+        bench_keep(filter.filter(readings.next()));
+    return (bench_now_ns() - start) / (double)READINGS;
+}
+
+//--- Definition of run()
+template <int N>
+void run()
+{
+    char what[48];
+    snprintf(what, sizeof(what), "median of %d matches the brute force", N);
+    bench_check(check<N>(), what);
+
+    MedianFilter<int32_t, N> median(SPIKE_REJECT, LIMIT);
+    BruteMedian<N> brute;
+    double heaps = time_filter(median);
+    double sorted = time_filter(brute);
+    printf("N = %3d  MedianFilter %7.1f ns  sort %8.1f ns per reading\n",
+           N, heaps, sorted);
+}
+
+int main()
+{
+    run<5>();
+    run<15>();
+    run<31>();
+    run<63>();
+    run<127>();
+    run<255>();
+    return bench_exit();
+}
@@ -0,0 +1,123 @@
+/*-- pid_trace.cpp--------------------------------------------------------
+   Replays a recorded trace through FanPid and checks that every duty is
+   the same, to the last bit. A trace is a CSV file: a "# gains" line
+   with kp, ki, kd (Q16) and the derivative filter (ms), then one line
+   per update with the time (ms), the measurement and the setpoint
+   (centi-degrees) and the duty (Q16) the controller gave.
+   HostBench/pid_trace.csv was recorded with --record: 10 minutes of the
+   default gains on DEFAULT_PLANT, from 40C towards a setpoint of 35C
+   changed to 38C after 5 minutes, with CONTROL_PERIOD updates. A change
+   to FanPid that alters its output fails the replay; record the trace
+   again only when the change is intended.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ITempFixed -IFanPid -IThermalPlant \
+           HostBench/pid_trace.cpp FanPid/FanPid.cpp \
+           ThermalPlant/ThermalPlant.cpp -o pid_trace
+       ./pid_trace HostBench/pid_trace.csv
+       ./pid_trace --record HostBench/pid_trace.csv
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "HostBench.h"
+#include "FanPid.h"
+#include "ThermalPlant.h"
+
+// the gains of fan_pid in driver.h, and its derivative filter (ms)
+const PidGains GAINS = { 6554, 328, 13107 };
+const uint32_t FILTER_MS = 2000;
+// the control period of pwm(), ms
+const uint32_t PERIOD_MS = 250;
+// the length of the recording and when its setpoint changes, ms
+const uint32_t RECORD_MS = 600000;
+const uint32_t STEP_MS = 300000;
+
+//--- Definition of record()
+static int record(const char * path)
+{
+    FILE * out = fopen(path, "w");
+    if(out == 0)
+    {
+        printf("cannot write %s\n", path);
+        return 1;
+    }
+    FanPid pid(GAINS, FILTER_MS);
+    ThermalPlant plant(DEFAULT_PLANT, 40.0f);
+    fprintf(out, "# gains %ld %ld %ld %lu\n", (long)GAINS.kp,
+            (long)GAINS.ki, (long)GAINS.kd, (unsigned long)FILTER_MS);
+    fprintf(out, "# ms,measured,setpoint,duty\n");
+    for(uint32_t ms = PERIOD_MS; ms <= RECORD_MS; ms += PERIOD_MS)
+    {
+        centi_t setpoint = ms <= STEP_MS ? 3500 : 3800;
+        centi_t measured = plant.sensor();
+        int32_t duty = pid.update(setpoint, measured, PERIOD_MS);
+        fprintf(out, "%lu,%ld,%ld,%ld\n", (unsigned long)ms, (long)measured,
+                (long)setpoint, (long)duty);
+        plant.step(duty / (float)PID_ONE, PERIOD_MS / 1000.0f);
+    }
+    fclose(out);
+    printf("recorded %lu updates in %s\n",
+           (unsigned long)(RECORD_MS / PERIOD_MS), path);
+    return 0;
+}
+
+//--- Definition of replay()
+static int replay(const char * path)
+{
+    FILE * in = fopen(path, "r");
+    if(in == 0)
+    {
+        printf("cannot read %s\n", path);
+        return 1;
+    }
+    long kp, ki, kd;
+    unsigned long filter;
+    if(fscanf(in, "# gains %ld %ld %ld %lu\n", &kp, &ki, &kd, &filter) != 4)
+    {
+        printf("%s: no gains line\n", path);
+        fclose(in);
+        return 1;
+    }
+    PidGains gains = { (int32_t)kp, (int32_t)ki, (int32_t)kd };
+    FanPid pid(gains, filter);
+
+    char line[128];
+    unsigned long previous = 0;
+    int updates = 0, mismatches = 0;
+    while(fgets(line, sizeof(line), in) != 0)
+    {
+        unsigned long ms;
+        long measured, setpoint, duty;
+        if(line[0] == '#')
+            continue;
+        if(sscanf(line, "%lu,%ld,%ld,%ld", &ms, &measured, &setpoint,
+                  &duty) != 4)
+        {
+            bench_check(false, "every line of the trace is readable");
+            continue;
+        }
+        // the first update follows a control period like the others
+        uint32_t dt = previous == 0 ? PERIOD_MS : ms - previous;
+        previous = ms;
+        int32_t got = pid.update(setpoint, measured, dt);
+        updates++;
+        if(got != duty && mismatches++ < 5)
+            printf("at %lu ms: duty %ld recorded, %ld now\n", ms, duty,
+                   (long)got);
+    }
+    fclose(in);
+    printf("%d updates replayed, %d different\n", updates, mismatches);
+    bench_check(updates > 0, "the trace holds updates");
+    bench_check(mismatches == 0, "every duty matches the trace");
+    return bench_exit();
+}
+
+int main(int argc, char ** argv)
+{
+    if(argc == 3 && strcmp(argv[1], "--record") == 0)
+        return record(argv[2]);
+    if(argc == 2)
+        return replay(argv[1]);
+    printf("usage: pid_trace [--record] trace.csv\n");
+    return 2;
+}
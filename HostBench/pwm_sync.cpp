@@ -0,0 +1,126 @@
+/*-- pwm_sync.cpp---------------------------------------------------------
+   Checks the conversions AdcDma synchronizes with the fan PWM against the
+   simulated PWM timer of sim_pwm(): the 1 ms period of driver.h at a
+   1 MHz tick, the 20 us guard of sync_to_pwm() and 1 to 8 channels.
+     - the phase: for every duty (0 to 1000 ticks on), follow_pwm() puts
+       the start of the conversions in the settled off-period (guard after
+       the falling edge, guard + the scan before the next rising one)
+       whenever it is long enough; otherwise in the settled on-period;
+       otherwise in the longer of the two; and always inside the period
+     - the rate: for the sampling rates of driver.h (1/12 Hz to 8/3 Hz,
+       64 conversions a reading), reload() starts a conversion every n
+       PWM periods, n the whole number nearest to the periods the rate
+       asks for (at least 2), and output_rate() reports the rate of n
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -IAdcDma HostBench/pwm_sync.cpp \
+           AdcDma/AdcDma.cpp -o pwm_sync && ./pwm_sync
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <math.h>
+#include "HostBench.h"
+#include "AdcDma.h"
+
+// the PWM of driver.h: a 1 ms period at a 1 MHz tick
+const uint32_t PERIOD = 1000;
+const uint32_t TICK_HZ = 1000000;
+// the settling time after an edge, and a scan pass per channel, ticks
+const uint32_t GUARD = 20;
+const uint32_t PASS = 5;
+// the conversions of a reading
+const int OVERSAMPLE = 64;
+
+//--- Definition of sweep(): every duty, for count channels; returns the
+// number of duties the conversions fit in the off-period of
+static int sweep(int count)
+{
+    PinName pins[ADCDMA_MAX_CHANNELS] = { 0 };
+    AdcDma adc(pins, count, OVERSAMPLE, 1 / 3.0f);
+    adc.sim_pwm(PERIOD, 0, TICK_HZ);
+    adc.sync_to_pwm(true, GUARD);
+    uint32_t window = PASS * count;
+    int quiet = 0;
+    bool ok = true;
+    for(uint32_t pulse = 0; pulse <= PERIOD; pulse++)
+    {
+        adc.sim_pwm(PERIOD, pulse, TICK_HZ);
+        adc.follow_pwm();
+        uint32_t start = adc.pwm_compare();
+        uint32_t end = start + window;
+        uint32_t off = PERIOD - pulse;
+        ok = ok && start >= 1 && start <= PERIOD - 1;
+        if(pulse == 0 || off == 0)
+            // no edge at all
+            continue;
+        if(off >= 2 * GUARD + window)
+        {
+            // settled off-period
+            ok = ok && start >= pulse + GUARD && end + GUARD <= PERIOD;
+            quiet++;
+        }
+        else if(pulse >= 2 * GUARD + window)
+            // settled on-period
+            ok = ok && start >= GUARD && end + GUARD <= pulse;
+        else if(off >= pulse)
+            ok = ok && start >= pulse;
+        else
+            ok = ok && end <= pulse;
+    }
+    printf("  %d channel(s): off-period for %d of the 999 switching duties"
+           " (up to %.1f%% on)\n", count, quiet,
+           (PERIOD - 2 * GUARD - window) / 10.0);
+    bench_check(ok, "the conversions start where the sensor settled");
+    return quiet;
+}
+
+//--- Definition of nearest(): whether divider is the whole number
+// nearest to exact (either one at a tie, as reload() rounds in float),
+// and at least 2
+static bool nearest(double divider, double exact)
+{
+    if(fabs(divider - floor(divider + 0.5)) > 1e-3)
+        return false;
+    if(exact < 2)
+        return fabs(divider - 2) < 1e-3;
+    return fabs(divider - exact) <= 0.5 + 1e-4;
+}
+
+//--- Definition of rate(): the divider of an output rate
+static void rate(float requested)
+{
+    AdcDma adc(0, OVERSAMPLE, requested);
+    adc.sim_pwm(PERIOD, PERIOD / 2, TICK_HZ);
+    adc.sync_to_pwm(true, GUARD);
+    // the PWM periods per conversion, as a real number and as produced
+    double exact = (double)TICK_HZ / (PERIOD * requested * OVERSAMPLE);
+    double divider = (double)TICK_HZ
+                     / (PERIOD * adc.output_rate() * OVERSAMPLE);
+    printf("  %7.4f Hz: %8.2f periods a conversion, divided by %4.0f,"
+           " %7.4f Hz\n", requested, exact, divider, adc.output_rate());
+    bench_check(nearest(divider, exact),
+                "the periods are divided by the nearest whole number");
+
+    // a new rate reloads the divider
+    adc.set_output_rate(requested * 2);
+    divider = (double)TICK_HZ / (PERIOD * adc.output_rate() * OVERSAMPLE);
+    bench_check(nearest(divider, exact / 2),
+                "set_output_rate() reloads the divider");
+}
+
+int main()
+{
+    printf("Phase of the conversions, %u us period, %u us guard\n",
+           (unsigned)PERIOD, (unsigned)GUARD);
+    int quiet = sweep(1);
+    bench_check(quiet == (int)(PERIOD - 2 * GUARD - PASS),
+                "one channel fits the off-period up to 95.5% on");
+    sweep(3);
+    sweep(8);
+
+    printf("Rate of the readings, %d conversions each\n", OVERSAMPLE);
+    for(int level = 0; level < 6; level++)
+        rate(1 / 12.0f * (1 << level));
+    // faster than the PWM allows: every other period
+    rate(16.0f);
+    return bench_exit();
+}
@@ -0,0 +1,144 @@
+/*-- queue_bench.cpp------------------------------------------------------
+   Compares TempQueue with the class it replaced, whose average() loops
+   over the whole window, for windows of 10, 100 and 1000 readings. Both
+   are timed per reading as the averaging thread uses them: one enqueue
+   and the average of the window (then, for TempQueue, also the spread,
+   the minimum and the maximum). The statistics of TempQueue are also
+   checked against a recomputation over the window.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ITempFixed -ITempQueue \
+           HostBench/queue_bench.cpp -o queue_bench && ./queue_bench
+-------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include "HostBench.h"
+#include "TempQueue.h"
+
+// the readings checked and timed per window size
+const int READINGS = 200000;
+
+// The original TempQueue (float values, the average recomputed by a loop
+// over the window), with its capacity as a parameter
+template <int N>
+class LoopQueue
+{
+ public:
+  LoopQueue() : count(0), full(false) {}
+  void enqueue(const float & value)
+  {
+      if(count > N - 1)
+      {
+          count = 0;
+          full = true;
+      }
+      myArray[count++] = value;
+  }
+  float average() const
+  {
+      int size = full ? N : count;
+      float avg = 0;
+      for(int i = 0; i < size; i++)
+          avg += myArray[i];
+      return avg / size;
+  }
+ private:
+  float myArray[N];
+  int count;
+  bool full;
+};
+
+// A reproducible stream of readings around 25C, centi-degrees
+class Readings
+{
+ public:
+  Readings() : mySeed(1) {}
+  centi_t next()
+  {
+      mySeed = mySeed * 1103515245u + 12345u;
+      return 2500 + (centi_t)((mySeed >> 8) % 1000) - 500;
+  }
+ private:
+  uint32_t mySeed;
+};
+
+//--- Definition of check(): the statistics against a recomputation
+template <int N>
+bool check()
+{
+    TempQueue<centi_t, N> queue;
+    centi_t window[N];
+    Readings readings;
+    for(int i = 0; i < READINGS / 10; i++)
+    {
+        window[i % N] = readings.next();
+        queue.enqueue(window[i % N]);
+        int size = i + 1 < N ? i + 1 : N;
+        double sum = 0, squares = 0;
+        centi_t low = window[0], high = window[0];
+        for(int j = 0; j < size; j++)
+        {
+            sum += window[j];
+            squares += (double)window[j] * window[j];
+            if(window[j] < low)
+                low = window[j];
+            if(window[j] > high)
+                high = window[j];
+        }
+        double mean = sum / size;
+        double deviation = sqrt(squares / size - mean * mean);
+        if(fabs(queue.average() - mean) > 0.5
+           || fabs(queue.stddev() - deviation) > 1
+           || queue.minimum() != low || queue.maximum() != high)
+            return false;
+    }
+    return true;
+}
+
+//--- Definition of run()
+template <int N>
+void run()
+{
+    char what[48];
+    snprintf(what, sizeof(what), "statistics of %d readings", N);
+    bench_check(check<N>(), what);
+
+    LoopQueue<N> loop;
+    Readings readings;
+    uint64_t start = bench_now_ns();
+    for(int i = 0; i < READINGS; i++)
+    {
+        loop.enqueue(readings.next() / 100.0f);
+        bench_keep((int64_t)loop.average());
+    }
+    double before = (bench_now_ns() - start) / (double)READINGS;
+
+    static TempQueue<centi_t, N> queue;
+    start = bench_now_ns();
+    for(int i = 0; i < READINGS; i++)
+    {
+        queue.enqueue(readings.next());
+        bench_keep(queue.average());
+    }
+    double after = (bench_now_ns() - start) / (double)READINGS;
+
+    // with the spread, the minimum and the maximum the loop never gave
+    start = bench_now_ns();
+    for(int i = 0; i < READINGS; i++)
+    {
+        queue.enqueue(readings.next());
+        bench_keep(queue.average() + queue.stddev() + queue.minimum()
+                   + queue.maximum());
+    }
+    double all = (bench_now_ns() - start) / (double)READINGS;
+    printf("N = %4d  loop %6.1f ns  TempQueue %5.1f ns,"
+           " with stddev/min/max %5.1f ns\n", N, before, after, all);
+}
+
+int main()
+{
+    run<10>();
+    run<100>();
+    run<1000>();
+    return bench_exit();
+}
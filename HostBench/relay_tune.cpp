@@ -0,0 +1,56 @@
+/*-- relay_tune.cpp-------------------------------------------------------
+   Runs the relay auto-tune of the remote session against DEFAULT_PLANT,
+   through the decisions of pwm(), and prints the oscillation it measured
+   and the gains of each rule. Then runs the hour of ThermalScenario.h
+   with the gains of driver.h and with the tuned ones, and prints their
+   scores. Both the experiment and the runs start from the scenario's
+   25C; the runs are reproducible.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ITempFixed -IFanPid -IRelayTuner \
+           -IThermalPlant -IThermalSim -IFanControl -ISensorTable \
+           -IMedianFilter -IBandClassifier -ITrendEstimator -IAdaptiveRate \
+           HostBench/relay_tune.cpp ThermalSim/ThermalSim.cpp \
+           ThermalPlant/ThermalPlant.cpp FanControl/FanControl.cpp \
+           FanPid/FanPid.cpp RelayTuner/RelayTuner.cpp \
+           BandClassifier/BandClassifier.cpp \
+           TrendEstimator/TrendEstimator.cpp \
+           AdaptiveRate/AdaptiveRate.cpp -o relay_tune && ./relay_tune
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "ThermalScenario.h"
+
+//--- Definition of report()
+static SimResult report(const char * name, const PidGains & gains)
+{
+    ThermalPlant plant(DEFAULT_PLANT, SCENARIO_START, SCENARIO_SEED);
+    SimResult result = simulate_fan(plant, gains, SCENARIO);
+    printf("%-15s kp %6ld ki %4ld kd %7ld: overshoot %.2fC, settled %.0fs,"
+           " fan %.0fJ\n", name, (long)gains.kp, (long)gains.ki,
+           (long)gains.kd, result.overshoot, result.settling,
+           result.fan_energy);
+    return result;
+}
+
+int main()
+{
+    ThermalPlant plant(DEFAULT_PLANT, SCENARIO_START, SCENARIO_SEED);
+    RelayTuner tuner;
+    TuneState state = simulate_tune(plant, tuner, SCENARIO);
+    printf("relay around %.2fC: %s after %.0fs, %d cycles\n",
+           SCENARIO.setpoint / 100.0, state == TUNE_DONE ? "done" : "failed",
+           plant.time(), tuner.cycles());
+    if(!bench_check(state == TUNE_DONE, "the auto-tune succeeds"))
+        return bench_exit();
+    printf("Pu %.1fs, amplitude %.2fC\n", tuner.period() / 1000.0,
+           tuner.amplitude() / 100.0);
+
+    SimResult before = report("driver.h", SCENARIO_GAINS);
+    report("Ziegler-Nichols", tuner.gains(TUNE_ZIEGLER_NICHOLS));
+    SimResult after = report("Tyreus-Luyben",
+                             tuner.gains(TUNE_TYREUS_LUYBEN));
+    bench_check(after.overshoot < before.overshoot,
+                "the tuned gains (tune_rule) overshoot less");
+    return bench_exit();
+}
@@ -0,0 +1,133 @@
+/*-- sensor_bench.cpp-----------------------------------------------------
+   Checks the SensorTable conversions against the closed-form transfer
+   functions computed with libm, over every read_u16() code, and compares
+   the time of a table lookup with the time of the libm formula.
+   The table is built by the compiler in C++11 and before main() in C++98
+   (as on the board); both builds must print the same errors:
+       g++ -O2 -std=c++11 -IHostBench -ITempFixed -ISensorTable \
+           HostBench/sensor_bench.cpp -o sensor_bench && ./sensor_bench
+       g++ -O2 -std=gnu++98 -IHostBench -ITempFixed -ISensorTable \
+           HostBench/sensor_bench.cpp -o sensor_bench && ./sensor_bench
+-------------------------------------------------------------------------*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "HostBench.h"
+#include "SensorTable.h"
+
+// the sensors of driver.h
+typedef NtcSensor<10000, 3950, 10000> Ntc;
+typedef Pt100Sensor<80000, 180000> Pt100;
+
+// the number of conversions timed per path
+const int SAMPLES = 1000000;
+
+//--- Definition of lm35_libm()
+static double lm35_libm(double x)
+{
+    return x * TEMP_FULL_SCALE;
+}
+
+//--- Definition of ntc_libm()
+static double ntc_libm(double x)
+{
+    double r = 10000.0 * x / (1 - x);
+    return 1 / (1 / 298.15 + log(r / 10000) / 3950) - 273.15;
+}
+
+//--- Definition of pt100_libm()
+static double pt100_libm(double x)
+{
+    double r = (80000 + 100000.0 * x) / 1000;
+    const double a = 3.9083e-3, b = -5.775e-7;
+    return (-a + sqrt(a * a - 4 * b * (1 - r / 100))) / (2 * b);
+}
+
+//--- Definition of worst_error()
+// the largest difference (C) between the table and libm over the codes
+// whose temperature lies between low and high C
+static double worst_error(centi_t (* table)(uint16_t),
+                          double (* libm)(double), double low, double high)
+{
+    double worst = 0;
+    for(uint32_t code = 1; code < 0xFFFF; code++)
+    {
+        double exact = libm(code / 65535.0);
+        if(exact < low || exact > high)
+            continue;
+        double error = fabs(table((uint16_t)code) / 100.0 - exact);
+        if(error > worst)
+            worst = error;
+    }
+    return worst;
+}
+
+//--- Definition of time_table()
+static double time_table(centi_t (* table)(uint16_t))
+{
+    uint32_t code = 12345;
+    uint64_t start = bench_now_ns();
+    for(int i = 0; i < SAMPLES; i++)
+    {
+        code = (code * 1103515245u + 12345u) & 0xFFFF;
+        bench_keep(table((uint16_t)code));
+    }
+    return (bench_now_ns() - start) / (double)SAMPLES;
+}
+
+//--- Definition of time_libm()
+static double time_libm(double (* libm)(double))
+{
+    uint32_t code = 12345;
+    uint64_t start = bench_now_ns();
+    for(int i = 0; i < SAMPLES; i++)
+    {
+        code = (code * 1103515245u + 12345u) & 0xFFFF;
+        // as the firmware would: code to fraction, formula, centi-degrees
+        bench_keep((int64_t)(libm((code | 1) / 65535.0) * 100 + 0.5));
+    }
+    return (bench_now_ns() - start) / (double)SAMPLES;
+}
+
+int main()
+{
+    printf("C++ %ld, table of %d entries\n", (long)__cplusplus,
+           SensorTable<Ntc>::SIZE);
+
+    // the series and Newton math of the table against libm, at the entries
+    int worst_entry = 0;
+    for(int i = 1; i < SensorTable<Ntc>::SIZE - 1; i++)
+    {
+        double x = (double)i / (SensorTable<Ntc>::SIZE - 1);
+        int ntc = SensorTable<Ntc>::entry(i) - (int)floor(ntc_libm(x) * 100
+                                                          + 0.5);
+        int pt100 = SensorTable<Pt100>::entry(i)
+                    - (int)floor(pt100_libm(x) * 100 + 0.5);
+        if(abs(ntc) > worst_entry)
+            worst_entry = abs(ntc);
+        if(abs(pt100) > worst_entry)
+            worst_entry = abs(pt100);
+    }
+    printf("entries: worst %d centi-degree(s) from libm\n", worst_entry);
+    bench_check(worst_entry <= 1, "the entries round libm's values");
+
+    // the interpolation between the entries, over the useful ranges
+    double lm35 = worst_error(&SensorTable<Lm35Sensor>::convert, lm35_libm,
+                              -1000, 1000);
+    double ntc = worst_error(&SensorTable<Ntc>::convert, ntc_libm, 0, 100);
+    double pt100 = worst_error(&SensorTable<Pt100>::convert, pt100_libm,
+                               -1000, 1000);
+    printf("LM35  full span: worst error %.3fC\n", lm35);
+    printf("NTC   0 - 100C:  worst error %.3fC\n", ntc);
+    printf("PT100 full span: worst error %.3fC\n", pt100);
+    bench_check(lm35 <= 0.02, "LM35 within 0.02C");
+    bench_check(ntc <= 0.15, "NTC within 0.15C between 0 and 100C");
+    bench_check(pt100 <= 0.03, "PT100 within 0.03C");
+
+    printf("NTC   table %6.1f ns   libm log()  %6.1f ns per conversion\n",
+           time_table(&SensorTable<Ntc>::convert), time_libm(ntc_libm));
+    printf("PT100 table %6.1f ns   libm sqrt() %6.1f ns per conversion\n",
+           time_table(&SensorTable<Pt100>::convert), time_libm(pt100_libm));
+    return bench_exit();
+}
@@ -0,0 +1,187 @@
+/*-- smooth_bench.cpp-----------------------------------------------------
+   Checks the portable kernel of Smoother (the one built without
+   TEMP_USE_CMSIS_DSP) against a reference direct form I in Q31 written
+   here after arm_biquad_cascade_df1_q31(): 64-bit sums of the five
+   products of a section, shifted down by 31 - postShift and truncated to
+   32 bits, the output of a section the input of the next, one sample
+   through the whole cascade at a time. On the same readings (a random
+   walk around 25C with noise, fed in blocks of 1 to 100 readings, so the
+   32-reading passes of process() and the state between blocks are
+   crossed) every Q31 output of sim_process() must equal the reference,
+   for the one-pole IIR and low-passes of 1 to 3 sections, and across a
+   change of filter (the new one started from the last output in steady
+   state). process() must return the same outputs rounded back to
+   centi-degrees, and a low-pass must settle on a step.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ISmoother -ITempFixed \
+           HostBench/smooth_bench.cpp Smoother/Smoother.cpp \
+           -o smooth_bench && ./smooth_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "Smoother.h"
+
+// the readings of a run
+const int READINGS = 20000;
+// the reading the second filter takes over at
+const int SWITCH = 9000;
+
+// The reference cascade, a sample at a time
+class Reference
+{
+ public:
+  // starts config from a steady state at value
+  void start(const SmoothConfig & config, int32_t value)
+  {
+      myConfig = config;
+      for(int i = 0; i < 4 * SMOOTH_MAX_STAGES; i++)
+          myState[i] = value;
+  }
+  int32_t step(int32_t x)
+  {
+      for(int s = 0; s < myConfig.stages; s++)
+      {
+          const int32_t * b = myConfig.coeffs + 5 * s;
+          int32_t * state = myState + 4 * s;
+          int64_t acc = (int64_t)b[0] * x;
+          acc += (int64_t)b[1] * state[0];
+          acc += (int64_t)b[2] * state[1];
+          acc += (int64_t)b[3] * state[2];
+          acc += (int64_t)b[4] * state[3];
+          int32_t y = (int32_t)(acc >> (31 - myConfig.postShift));
+          state[1] = state[0];
+          state[0] = x;
+          state[3] = state[2];
+          state[2] = y;
+          x = y;
+      }
+      return x;
+  }
+ private:
+  SmoothConfig myConfig;
+  int32_t myState[4 * SMOOTH_MAX_STAGES];
+};
+
+// A reproducible random walk around 25C, give or take 0.5C of noise
+class Readings
+{
+ public:
+  Readings() : mySeed(7), myLevel(2500) {}
+  centi_t next()
+  {
+      mySeed = mySeed * 1103515245u + 12345u;
+      uint32_t r = mySeed >> 8;
+      myLevel += (int32_t)(r % 9) - 4;
+      return myLevel + (int32_t)((r >> 8) % 101) - 50;
+  }
+  // a block size of 1 to 100
+  int block()
+  {
+      mySeed = mySeed * 1103515245u + 12345u;
+      return 1 + (int)((mySeed >> 16) % 100);
+  }
+ private:
+  uint32_t mySeed;
+  centi_t myLevel;
+};
+
+//--- Definition of compare(): runs first, then second from SWITCH on;
+// returns whether every output matches the reference
+static bool compare(const char * name, const SmoothConfig & first,
+                    const SmoothConfig & second)
+{
+    static centi_t in[READINGS];
+    static int32_t scaled[READINGS], out[READINGS], expected[READINGS];
+    static centi_t rounded[READINGS];
+    Readings readings;
+    for(int i = 0; i < READINGS; i++)
+    {
+        in[i] = readings.next();
+        scaled[i] = in[i] * (1 << SMOOTH_SCALE);
+    }
+
+    // the reference, primed with the first reading as Smoother is
+    Reference reference;
+    reference.start(first, scaled[0]);
+    for(int i = 0; i < READINGS; i++)
+    {
+        if(i == SWITCH)
+            reference.start(second, expected[i - 1]);
+        expected[i] = reference.step(scaled[i]);
+    }
+
+    // the same readings in blocks, Q31 and rounded
+    Smoother q31, centi;
+    q31.configure(first);
+    centi.configure(first);
+    for(int done = 0; done < READINGS; )
+    {
+        int n = readings.block();
+        if(done < SWITCH && done + n > SWITCH)
+            n = SWITCH - done;
+        if(done + n > READINGS)
+            n = READINGS - done;
+        if(done == SWITCH)
+        {
+            q31.configure(second);
+            centi.configure(second);
+        }
+        q31.sim_process(scaled + done, out + done, n);
+        centi.process(in + done, rounded + done, n);
+        done += n;
+    }
+
+    int mismatches = 0, rounding = 0;
+    for(int i = 0; i < READINGS; i++)
+    {
+        if(out[i] != expected[i])
+            mismatches++;
+        if(rounded[i] != (expected[i] + (1 << (SMOOTH_SCALE - 1)))
+                         >> SMOOTH_SCALE)
+            rounding++;
+    }
+    printf("  %-28s %d of %d outputs differ, %d rounded ones\n", name,
+           mismatches, READINGS, rounding);
+    return mismatches == 0 && rounding == 0;
+}
+
+//--- Definition of settles(): the output of a step from 20C to 30C after
+// a while
+static centi_t settles(const SmoothConfig & config)
+{
+    Smoother smoother;
+    smoother.configure(config);
+    centi_t in[SMOOTH_BLOCK], out[SMOOTH_BLOCK];
+    for(int i = 0; i < SMOOTH_BLOCK; i++)
+        in[i] = 2000;
+    smoother.process(in, out, SMOOTH_BLOCK);
+    for(int i = 0; i < SMOOTH_BLOCK; i++)
+        in[i] = 3000;
+    for(int block = 0; block < 100; block++)
+        smoother.process(in, out, SMOOTH_BLOCK);
+    return out[SMOOTH_BLOCK - 1];
+}
+
+int main()
+{
+    printf("Portable kernel against the reference, %d readings\n",
+           READINGS);
+    bool ok = compare("one_pole(0.05)", Smoother::one_pole(0.05f),
+                      Smoother::one_pole(0.2f));
+    ok = compare("lowpass(0.05, 1)", Smoother::lowpass(0.05f, 1),
+                 Smoother::lowpass(0.1f, 1)) && ok;
+    ok = compare("lowpass(0.02, 2)", Smoother::lowpass(0.02f, 2),
+                 Smoother::lowpass(0.1f, 3)) && ok;
+    ok = compare("lowpass(0.01, 3)", Smoother::lowpass(0.01f, 3),
+                 Smoother::one_pole(0.05f)) && ok;
+    bench_check(ok, "the portable kernel computes the bits of the reference");
+
+    centi_t one = settles(Smoother::one_pole(0.05f));
+    centi_t three = settles(Smoother::lowpass(0.02f, 3));
+    printf("A step from 2000 to 3000: one_pole %ld, lowpass of 3 sections"
+           " %ld\n", (long)one, (long)three);
+    bench_check(one >= 2999 && one <= 3001 && three >= 2999 && three <= 3001,
+                "the filters settle on a step");
+    return bench_exit();
+}
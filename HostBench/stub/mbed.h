@@ -0,0 +1,170 @@
+/* mbed.h (HostBench stub) contains the part of the mbed API the host
+   simulations use, under virtual time.
+   us_ticker_read() returns the virtual clock of the simulation; only
+   Thread::signal_wait() and Thread::wait() of the rtos.h stub and the
+   busy waits (wait(), wait_us()) move it. There is a single thread of
+   execution, so the critical sections do nothing.
+   The digital pins write to and read from the model of the simulation
+   (sim_pins()), e.g. the HD44780 of HostBench/SimLcd.h, pin by pin; a bus
+   writes its pins from the lowest bit. A Timeout never fires: the host
+   programs drive the TextLCD in its blocking mode.
+-------------------------------------------------------------------------*/
+
+#ifndef HOSTBENCH_MBED
+#define HOSTBENCH_MBED
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef int PinName;
+const PinName NC = -1;
+
+/*-----------------------------------------------------------------------
+  Retrieve the virtual clock (us) of the simulation, to read or set.
+ ----------------------------------------------------------------------*/
+inline uint32_t & sim_clock()
+{
+    static uint32_t now = 0;
+    return now;
+}
+
+inline uint32_t us_ticker_read()
+{
+    return sim_clock();
+}
+
+inline void wait_us(int us)
+{
+    sim_clock() += us;
+}
+
+inline void wait(float s)
+{
+    sim_clock() += (uint32_t)(s * 1000000 + 0.5f);
+}
+
+inline void core_util_critical_section_enter()
+{
+}
+
+inline void core_util_critical_section_exit()
+{
+}
+
+// The hardware the pins of a simulation are wired to
+class SimPins
+{
+ public:
+  virtual ~SimPins() {}
+  // the output pin is driven to value (0 or 1)
+  virtual void write(PinName pin, int value) = 0;
+  // the level of the input pin
+  virtual int read(PinName pin) = 0;
+};
+
+/*-----------------------------------------------------------------------
+  Retrieve the model the pins are wired to (0: none), to read or set.
+ ----------------------------------------------------------------------*/
+inline SimPins *& sim_pins()
+{
+    static SimPins * pins = 0;
+    return pins;
+}
+
+class DigitalOut
+{
+ public:
+  DigitalOut(PinName pin, int value = 0) : myPin(pin) { write(value); }
+  void write(int value)
+  {
+      myValue = value != 0;
+      if(sim_pins())
+          sim_pins()->write(myPin, myValue);
+  }
+  int read() { return myValue; }
+  DigitalOut & operator=(int value) { write(value); return *this; }
+  operator int() { return myValue; }
+ private:
+  PinName myPin;
+  int myValue;
+};
+
+class BusInOut
+{
+ public:
+  BusInOut(PinName p0, PinName p1, PinName p2, PinName p3)
+      : myValue(0), isOutput(false)
+  {
+      myPins[0] = p0;
+      myPins[1] = p1;
+      myPins[2] = p2;
+      myPins[3] = p3;
+  }
+  void write(int value)
+  {
+      myValue = value & 0xF;
+      if(!isOutput || !sim_pins())
+          return;
+      for(int i = 0; i < 4; i++)
+          sim_pins()->write(myPins[i], (myValue >> i) & 1);
+  }
+  int read()
+  {
+      if(isOutput || !sim_pins())
+          return myValue;
+      int value = 0;
+      for(int i = 0; i < 4; i++)
+          value |= (sim_pins()->read(myPins[i]) & 1) << i;
+      return value;
+  }
+  void output() { isOutput = true; write(myValue); }
+  void input() { isOutput = false; }
+  BusInOut & operator=(int value) { write(value); return *this; }
+  operator int() { return read(); }
+ private:
+  PinName myPins[4];
+  int myValue;
+  bool isOutput;
+};
+
+class BusOut : public BusInOut
+{
+ public:
+  BusOut(PinName p0, PinName p1, PinName p2, PinName p3)
+      : BusInOut(p0, p1, p2, p3) { output(); }
+  BusOut & operator=(int value) { write(value); return *this; }
+};
+
+class Timeout
+{
+ public:
+  template<typename T>
+  void attach_us(T *, void (T::*)(), uint32_t) {}
+  void detach() {}
+};
+
+class Stream
+{
+ public:
+  virtual ~Stream() {}
+  int putc(int c) { return _putc(c); }
+  int getc() { return _getc(); }
+  int printf(const char * format, ...)
+  {
+      char text[128];
+      va_list args;
+      va_start(args, format);
+      int length = vsnprintf(text, sizeof(text), format, args);
+      va_end(args);
+      for(int i = 0; text[i] != 0; i++)
+          _putc(text[i]);
+      return length;
+  }
+ protected:
+  virtual int _putc(int c) = 0;
+  virtual int _getc() = 0;
+};
+
+#endif
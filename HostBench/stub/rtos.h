@@ -0,0 +1,139 @@
+/* rtos.h (HostBench stub) contains the part of the mbed-rtos API the host
+   simulations use, under virtual time.
+   One simulated thread runs at a time (sim_running()). When it waits for
+   a signal, the clock of the mbed.h stub jumps from event to event of
+   the simulation (sim_events()), running each, until the signal is set
+   or the timeout has passed. When no event is left for a thread waiting
+   without a timeout, SimOver is thrown to end the run. Thread::wait()
+   lets the events run until its time has passed. The mutexes do nothing
+   and the thread of the simulation has no id (osSignalSet() is only
+   counted).
+-------------------------------------------------------------------------*/
+
+#ifndef HOSTBENCH_RTOS
+#define HOSTBENCH_RTOS
+
+#include <stdint.h>
+#include "mbed.h"
+
+#define osWaitForever 0xFFFFFFFFu
+
+typedef void * osThreadId;
+
+// The events of a simulation, in time order
+class SimEvents
+{
+ public:
+  virtual ~SimEvents() {}
+  // the time (us) of the next event; false if there is none
+  virtual bool next(uint32_t & time_us) = 0;
+  // run the next event, at its time
+  virtual void run() = 0;
+};
+
+// Thrown when a thread waits forever and no event is left
+struct SimOver {};
+
+class Thread;
+
+/*-----------------------------------------------------------------------
+  Retrieve the events of the simulation, to read or set.
+ ----------------------------------------------------------------------*/
+inline SimEvents *& sim_events()
+{
+    static SimEvents * events = 0;
+    return events;
+}
+
+/*-----------------------------------------------------------------------
+  Retrieve the thread being simulated, to read or set.
+ ----------------------------------------------------------------------*/
+inline Thread *& sim_running()
+{
+    static Thread * running = 0;
+    return running;
+}
+
+class Thread
+{
+ public:
+  Thread() : mySignals(0) {}
+
+  int32_t signal_set(int32_t signals)
+  {
+      mySignals |= signals;
+      return mySignals;
+  }
+
+  static osThreadId gettid()
+  {
+      return 0;
+  }
+
+  static int32_t wait(uint32_t millisec)
+  {
+      Thread self;
+      Thread * running = sim_running();
+      sim_running() = &self;
+      if(sim_events() != 0)
+          signal_wait(0x1, millisec);
+      else
+          sim_clock() += millisec * 1000;
+      sim_running() = running;
+      return 0;
+  }
+
+  static int32_t signal_wait(int32_t signals,
+                             uint32_t millisec = osWaitForever)
+  {
+      Thread & self = *sim_running();
+      uint64_t deadline = millisec == osWaitForever ? ~0ULL
+                          : sim_clock() + millisec * 1000ULL;
+      while((self.mySignals & signals) == 0)
+      {
+          uint32_t time_us;
+          bool more = sim_events()->next(time_us);
+          if(!more && millisec == osWaitForever)
+              throw SimOver();
+          if(!more || time_us > deadline)
+          {
+              // timed out (the events at the deadline run first)
+              sim_clock() = (uint32_t)deadline;
+              return 0;
+          }
+          sim_clock() = time_us;
+          sim_events()->run();
+      }
+      int32_t taken = self.mySignals & signals;
+      self.mySignals &= ~signals;
+      return taken;
+  }
+
+ private:
+  int32_t mySignals;
+};
+
+/*-----------------------------------------------------------------------
+  Retrieve the number of osSignalSet() calls, to read or set.
+ ----------------------------------------------------------------------*/
+inline unsigned & sim_signals()
+{
+    static unsigned signals = 0;
+    return signals;
+}
+
+inline int32_t osSignalSet(osThreadId, int32_t signals)
+{
+    sim_signals()++;
+    return signals;
+}
+
+class Mutex
+{
+ public:
+  void lock() {}
+  bool trylock() { return true; }
+  void unlock() {}
+};
+
+#endif
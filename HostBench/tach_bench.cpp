@@ -0,0 +1,186 @@
+/*-- tach_bench.cpp-------------------------------------------------------
+   Feeds FanTach simulated tachometer edges (sim_edge()) and checks:
+     - the speed of every 250 ms window (the CONTROL_PERIOD of pwm()) of
+       a steady fan, from 300 to 300000 rpm (10 Hz to 10 kHz of edges
+       with 2 pulses a turn), to one timer tick of the span it measures
+     - a fan stopping while driven: stalled after the 3 s of driver.h,
+       not before, and its speed falling towards 0
+     - a fan stopping while driven below the stall duty: not stalled
+     - a fan stopped while its outputs are held off by an emergency or a
+       remote session, then driven again: never stalled when pwm() passes
+       the duty on the pin (0 while held), stalled when it passes the
+       duty it last wrote
+   Then times sim_edge(), the same bookkeeping as the edge handler, over
+   10 kHz of edges. This is the host cost of the handler body only; the
+   board adds the interrupt entry and the dispatch of InterruptIn.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -IFanTach HostBench/tach_bench.cpp \
+           FanTach/FanTach.cpp -o tach_bench && ./tach_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "FanTach.h"
+
+// the tachometer of driver.h: 2 pulses a turn, stalled below 300 rpm for
+// 3 s at 30% or more
+const int PULSES = 2;
+const uint32_t STALL_RPM = 300;
+const int32_t STALL_DUTY = 19661;
+const uint32_t STALL_MS = 3000;
+// the window of pwm(), us, and full speed (Q16)
+const uint32_t WINDOW_US = 250000;
+const int32_t FULL = 65536;
+
+// A fan turning at a steady speed, from the first edge at a time
+class Fan
+{
+ public:
+  Fan(FanTach & tach, uint32_t start_us) : myTach(tach), myNext(start_us),
+                                           myPeriod(0), myFraction(0) {}
+  // turns at rpm from now on (0: stopped)
+  void spin(uint32_t rpm, uint32_t now_us)
+  {
+      // the edge period in 1/1000 us, so the speed is exact on average
+      myPeriod = rpm ? 60000000000ULL / ((uint64_t)rpm * PULSES) : 0;
+      if(myNext < now_us)
+          myNext = now_us;
+  }
+  // performs the edges up to time_us
+  void run(uint32_t time_us)
+  {
+      if(myPeriod == 0)
+          return;
+      while(myNext <= time_us)
+      {
+          myTach.sim_edge(myNext);
+          myFraction += myPeriod;
+          myNext += (uint32_t)(myFraction / 1000);
+          myFraction %= 1000;
+      }
+  }
+ private:
+  FanTach & myTach;
+  uint32_t myNext;
+  uint64_t myPeriod;
+  uint64_t myFraction;
+};
+
+//--- Definition of accuracy(): the speed of every window of a steady fan
+static void accuracy(uint32_t rpm)
+{
+    FanTach tach(0, PULSES, STALL_RPM, STALL_DUTY, STALL_MS);
+    Fan fan(tach, 123);
+    fan.spin(rpm, 0);
+    uint32_t worst = 0;
+    bool ok = true;
+    // the first windows only start the measure
+    for(uint32_t now = 0; now <= 20 * WINDOW_US; now += WINDOW_US)
+    {
+        fan.run(now);
+        uint32_t measured = tach.update(now, FULL);
+        if(now < 2 * WINDOW_US)
+            continue;
+        uint32_t error = measured > rpm ? measured - rpm : rpm - measured;
+        if(error > worst)
+            worst = error;
+        // the span covers about a window: one tick of it, plus rounding
+        ok = ok && error <= (uint64_t)rpm * 2 / WINDOW_US + 1;
+        ok = ok && !tach.stalled();
+    }
+    printf("  %6lu rpm (%5lu Hz of edges): worst error %lu rpm\n",
+           (unsigned long)rpm, (unsigned long)(rpm * PULSES / 60),
+           (unsigned long)worst);
+    bench_check(ok, "the speed of a steady fan is exact to one tick");
+}
+
+//--- Definition of stall(): the fan stops at 5 s while driven at duty;
+// returns when it was found stalled (0 if never within 20 s)
+static uint32_t stall(int32_t duty, uint32_t & rpm_at_stall)
+{
+    FanTach tach(0, PULSES, STALL_RPM, STALL_DUTY, STALL_MS);
+    Fan fan(tach, 0);
+    fan.spin(1200, 0);
+    rpm_at_stall = 0;
+    for(uint32_t now = 0; now <= 20000000; now += WINDOW_US)
+    {
+        fan.run(now);
+        if(now == 5000000)
+            fan.spin(0, now);
+        tach.update(now, duty);
+        if(tach.stalled())
+        {
+            rpm_at_stall = tach.rpm();
+            return now;
+        }
+    }
+    return 0;
+}
+
+//--- Definition of held(): the outputs are held off from 5 s to 65 s,
+// and the fan stops and spins up again; update() gets the duty on the
+// pin, or the full duty last written if pinned is false; returns whether
+// the fan was ever found stalled
+static bool held(bool pinned)
+{
+    FanTach tach(0, PULSES, STALL_RPM, STALL_DUTY, STALL_MS);
+    Fan fan(tach, 0);
+    fan.spin(1200, 0);
+    bool stalled = false;
+    for(uint32_t now = 0; now <= 80000000; now += WINDOW_US)
+    {
+        bool off = now >= 5000000 && now < 65000000;
+        fan.run(now);
+        if(now == 5000000)
+            fan.spin(0, now);
+        // it takes a second to turn again
+        if(now == 66000000)
+            fan.spin(1200, now);
+        tach.update(now, off && pinned ? 0 : FULL);
+        stalled = stalled || tach.stalled();
+    }
+    return stalled;
+}
+
+int main()
+{
+    printf("Steady fans, %u ms windows\n", (unsigned)(WINDOW_US / 1000));
+    const uint32_t speeds[] = { 300, 1200, 3000, 12000, 60000, 300000 };
+    for(unsigned i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+        accuracy(speeds[i]);
+
+    uint32_t rpm = 0;
+    uint32_t found = stall(FULL, rpm);
+    printf("Stopped at 5 s while driven at 100%%: stalled at %.2f s, %lu"
+           " rpm\n", found / 1e6, (unsigned long)rpm);
+    // the first slow window ends at 5.25 s: 3 s of slow windows later
+    bench_check(found >= 5000000 + STALL_MS * 1000
+                && found <= 5000000 + STALL_MS * 1000 + 2 * WINDOW_US,
+                "a driven fan that stops is stalled after the stall time");
+    bench_check(rpm < STALL_RPM, "the speed of a stopped fan falls");
+    found = stall(STALL_DUTY - 1, rpm);
+    printf("Stopped at 5 s while driven below the stall duty: %s\n",
+           found ? "stalled" : "not stalled");
+    bench_check(found == 0, "a fan driven below the stall duty may stop");
+    bool stalled = held(true);
+    printf("Held off for 60 s, then driven again: %s\n",
+           stalled ? "stalled" : "not stalled");
+    bench_check(!stalled, "a fan held off is not stalled");
+    stalled = held(false);
+    printf("The same, with the duty last written: %s\n",
+           stalled ? "stalled" : "not stalled");
+    bench_check(stalled, "the duty last written makes it stall");
+
+    // the host cost of the edge bookkeeping, at 10 kHz of edges
+    FanTach tach(0, PULSES, STALL_RPM, STALL_DUTY, STALL_MS);
+    const uint32_t EDGES = 10000000;
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < EDGES; i++)
+        tach.sim_edge(i * 100);
+    double ns = (double)(bench_now_ns() - start) / EDGES;
+    bench_keep(tach.edges());
+    printf("sim_edge(): %.2f ns an edge on the host, %.3f%% of a second"
+           " at 10 kHz\n", ns, ns * 10000 / 1e7);
+    bench_check(tach.edges() == EDGES, "every edge is counted");
+    return bench_exit();
+}
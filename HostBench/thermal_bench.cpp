@@ -0,0 +1,65 @@
+/*-- thermal_bench.cpp----------------------------------------------------
+   Runs the fan control of the unit against DEFAULT_PLANT for the hour of
+   ThermalScenario.h and prints the overshoot, the settling time and the
+   fan energy, then the same hour with one setting changed at a time. The
+   runs are reproducible: the same build prints the same numbers.
+   Build and run, from the root of the repository:
+       g++ -O2 -IHostBench -ITempFixed -IFanPid -IRelayTuner \
+           -IThermalPlant -IThermalSim -IFanControl -ISensorTable \
+           -IMedianFilter -IBandClassifier -ITrendEstimator -IAdaptiveRate \
+           HostBench/thermal_bench.cpp ThermalSim/ThermalSim.cpp \
+           ThermalPlant/ThermalPlant.cpp FanControl/FanControl.cpp \
+           FanPid/FanPid.cpp RelayTuner/RelayTuner.cpp \
+           BandClassifier/BandClassifier.cpp \
+           TrendEstimator/TrendEstimator.cpp \
+           AdaptiveRate/AdaptiveRate.cpp -o thermal_bench && ./thermal_bench
+-------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "HostBench.h"
+#include "ThermalScenario.h"
+
+//--- Definition of report()
+static SimResult report(const char * name, const SimSettings & settings)
+{
+    ThermalPlant plant(DEFAULT_PLANT, SCENARIO_START, SCENARIO_SEED);
+    uint64_t start = bench_now_ns();
+    SimResult result = simulate_fan(plant, SCENARIO_GAINS, settings);
+    double elapsed = (bench_now_ns() - start) / 1e6;
+    printf("%-22s %6.2fC %7.0fs %8.0fJ %7.2fC %6u %7.1fms\n", name,
+           result.overshoot, result.settling, result.fan_energy,
+           result.final_temp, result.duty_changes, elapsed);
+    return result;
+}
+
+int main()
+{
+    printf("%-22s %7s %8s %9s %8s %6s %9s\n", "run", "over", "settled",
+           "fan", "final", "writes", "host");
+    SimResult unit = report("unit settings", SCENARIO);
+
+    SimSettings changed = SCENARIO;
+    changed.period_ms = 3000;
+    report("control every 3 s", changed);
+
+    // a tempMax the overshoot crosses, where the band and the forecast
+    // take over from the controller
+    changed = SCENARIO;
+    changed.limit = 3600;
+    report("tempMax 36C", changed);
+    changed.horizon = 0;
+    report("tempMax 36C no pre-arm", changed);
+    changed.horizon = SCENARIO.horizon;
+    changed.hysteresis = 0;
+    report("tempMax 36C no hyst.", changed);
+
+    // the same arguments give the same run
+    ThermalPlant plant(DEFAULT_PLANT, SCENARIO_START, SCENARIO_SEED);
+    SimResult again = simulate_fan(plant, SCENARIO_GAINS, SCENARIO);
+    bench_check(again.overshoot == unit.overshoot
+                && again.settling == unit.settling
+                && again.fan_energy == unit.fan_energy
+                && again.duty_changes == unit.duty_changes,
+                "a run is reproducible");
+    return bench_exit();
+}
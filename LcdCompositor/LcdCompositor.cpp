@@ -0,0 +1,249 @@
+/*-- LcdCompositor.cpp-----------------------------------------------------
+         This file implements LcdLayer and LcdCompositor member functions.
+-------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "LcdCompositor.h"
+
+//--- Definition of LcdLayer constructor
+LcdLayer::LcdLayer(LcdCompositor & screen, LcdPriority priority,
+                   bool visible)
+    : myScreen(screen)
+{
+    myPriority = priority;
+    myRows = screen.myLcd.rows();
+    myColumns = screen.myLcd.columns();
+    memset(myCells, ' ', sizeof(myCells));
+    myColumn = 0;
+    myRow = 0;
+    isVisible = visible;
+    screen.myLayers[priority] = this;
+}
+
+//--- Definition of locate()
+void LcdLayer::locate(int column, int row)
+{
+    myScreen.myMutex.lock();
+    myColumn = column;
+    myRow = row;
+    myScreen.myMutex.unlock();
+}
+
+//--- Definition of cls()
+void LcdLayer::cls()
+{
+    myScreen.myMutex.lock();
+    memset(myCells, ' ', sizeof(myCells));
+    myColumn = 0;
+    myRow = 0;
+    myScreen.changed(this, isVisible);
+    myScreen.myMutex.unlock();
+}
+
+//--- Definition of draw()
+void LcdLayer::draw(char code)
+{
+    myScreen.myMutex.lock();
+    store(code);
+    myScreen.myMutex.unlock();
+}
+
+//--- Definition of glyph()
+char LcdLayer::glyph(const char * bitmap)
+{
+    return myScreen.glyph(bitmap);
+}
+
+//--- Definition of show()
+void LcdLayer::show()
+{
+    myScreen.myMutex.lock();
+    isVisible = true;
+    myScreen.changed(this, true);
+    myScreen.myMutex.unlock();
+}
+
+//--- Definition of hide()
+void LcdLayer::hide()
+{
+    myScreen.myMutex.lock();
+    // the layer below is rendered if this one was on top
+    bool shown = isVisible;
+    isVisible = false;
+    myScreen.changed(this, shown);
+    myScreen.myMutex.unlock();
+}
+
+//--- Definition of visible()
+bool LcdLayer::visible() const
+{
+    return isVisible;
+}
+
+//--- Definition of _putc()
+int LcdLayer::_putc(int value)
+{
+    myScreen.myMutex.lock();
+    // the same cursor moves as the TextLCD
+    if(value == '\n')
+    {
+        myColumn = 0;
+        myRow++;
+        if(myRow >= myRows)
+            myRow = 0;
+    }
+    else
+        store(value);
+    myScreen.myMutex.unlock();
+    return value;
+}
+
+//--- Definition of store()
+void LcdLayer::store(char code)
+{
+    // called with the mutex of the compositor held
+    if(myRow < myRows && myColumn < myColumns
+       && myCells[myRow][myColumn] != code)
+    {
+        myCells[myRow][myColumn] = code;
+        myScreen.changed(this, isVisible);
+    }
+    myColumn++;
+    if(myColumn >= myColumns)
+    {
+        myColumn = 0;
+        myRow++;
+    }
+    if(myRow >= myRows)
+        myRow = 0;
+}
+
+//--- Definition of _getc()
+int LcdLayer::_getc()
+{
+    return -1;
+}
+
+//--- Definition of LcdCompositor constructor
+LcdCompositor::LcdCompositor(TextLCD & lcd)
+    : myLcd(lcd)
+{
+    for(int i = 0; i < LAYERS; i++)
+        myLayers[i] = 0;
+    myOwner = 0;
+    myShown = -1;
+    isDirty = false;
+    memset(myGlyphs, 0, sizeof(myGlyphs));
+    for(int i = 0; i < LCD_GLYPHS; i++)
+        myGlyphUse[i] = 0;
+    myClock = 0;
+}
+
+//--- Definition of run()
+void LcdCompositor::run()
+{
+    myMutex.lock();
+    myOwner = Thread::gettid();
+    myMutex.unlock();
+    while(true)
+    {
+        render();
+        Thread::signal_wait(COMPOSITOR_SIGNAL);
+    }
+}
+
+//--- Definition of render()
+bool LcdCompositor::render()
+{
+    char cells[LCD_MAX_ROWS][LCD_MAX_COLUMNS];
+    char glyphs[LCD_GLYPHS][8];
+    bool defined[LCD_GLYPHS];
+    myMutex.lock();
+    int top = -1;
+    for(int i = LAYERS - 1; i >= 0 && top < 0; i--)
+        if(myLayers[i] != 0 && myLayers[i]->isVisible)
+            top = i;
+    if(top < 0 || (top == myShown && !isDirty))
+    {
+        myMutex.unlock();
+        return false;
+    }
+    // a copy, so the writers are not held up by the bus
+    memcpy(cells, myLayers[top]->myCells, sizeof(cells));
+    memcpy(glyphs, myGlyphs, sizeof(glyphs));
+    for(int i = 0; i < LCD_GLYPHS; i++)
+        defined[i] = myGlyphUse[i] != 0;
+    myShown = top;
+    isDirty = false;
+    myMutex.unlock();
+
+    // the glyphs first, so the new cells show the new bitmaps; only the
+    // rows that changed are sent
+    for(int i = 0; i < LCD_GLYPHS; i++)
+        if(defined[i])
+            myLcd.define(i, glyphs[i]);
+    // only the cells differing from the shadow of the TextLCD are sent;
+    // as codes, so a glyph is not taken for a control character
+    int rows = myLcd.rows();
+    int columns = myLcd.columns();
+    for(int row = 0; row < rows; row++)
+        for(int column = 0; column < columns; column++)
+            myLcd.cell(column, row, cells[row][column]);
+    return true;
+}
+
+//--- Definition of top()
+int LcdCompositor::top()
+{
+    myMutex.lock();
+    int shown = myShown;
+    myMutex.unlock();
+    return shown;
+}
+
+//--- Definition of glyph()
+char LcdCompositor::glyph(const char * bitmap)
+{
+    myMutex.lock();
+    int slot = -1;
+    int oldest = 0;
+    for(int i = 0; i < LCD_GLYPHS && slot < 0; i++)
+    {
+        if(myGlyphUse[i] != 0 && memcmp(myGlyphs[i], bitmap, 8) == 0)
+            slot = i;
+        else if(myGlyphUse[i] < myGlyphUse[oldest])
+            oldest = i;
+    }
+    if(slot < 0)
+    {
+        // evict the least recently requested bitmap
+        slot = oldest;
+        memcpy(myGlyphs[slot], bitmap, 8);
+        wake();
+    }
+    myGlyphUse[slot] = ++myClock;
+    myMutex.unlock();
+    return LCD_GLYPH + slot;
+}
+
+//--- Definition of changed()
+void LcdCompositor::changed(LcdLayer * layer, bool shown)
+{
+    // called with myMutex held; a change under a visible layer is kept
+    // in the cells of its layer until that one is on top
+    if(!shown)
+        return;
+    for(int i = LAYERS - 1; i > layer->myPriority; i--)
+        if(myLayers[i] != 0 && myLayers[i]->isVisible)
+            return;
+    wake();
+}
+
+//--- Definition of wake()
+void LcdCompositor::wake()
+{
+    // called with myMutex held
+    isDirty = true;
+    if(myOwner != 0)
+        osSignalSet(myOwner, COMPOSITOR_SIGNAL);
+}
@@ -0,0 +1,212 @@
+/* LcdCompositor.h contains the declarations of classes LcdCompositor and
+   LcdLayer.
+   The threads no longer write to the TextLCD: each writes into its own
+   layer, a full screen of characters kept in RAM with the same locate(),
+   cls() and printf() as the TextLCD. The layers have priorities
+   (emergency above the modal prompts above the status) and can be shown
+   or hidden. A single thread, the owner of the TextLCD, runs the
+   compositor: it is woken by every change to the layer on top and
+   renders that layer only, so writes from different threads can no
+   longer interleave on the panel, and the TextLCD shadow sends only the
+   cells that differ from what it shows. Clearing a layer costs no bus
+   time: cls() only blanks its cells.
+   The compositor also shares the 8 custom characters of the panel
+   between the layers: glyph() returns the character showing a bitmap,
+   giving it the least recently requested slot if no slot holds it yet,
+   and render() defines the slots before writing the cells (the TextLCD
+   only sends the rows of a slot that changed). As long as a screen uses
+   at most LCD_GLYPHS bitmaps, its glyphs are never evicted while drawn.
+   The glyphs are the codes 0-7 of the panel, which putc() would take
+   for control characters ('\n' among the codes 8-15 that also show
+   them): they are written with draw(), and the cells go to the TextLCD
+   with its cell(), so no code of a cell moves a cursor.
+   Basic operations (LcdLayer):
+     Constructor: Constructs a layer of a compositor at a priority
+     locate:      Moves the cursor of the layer
+     cls:         Blanks the layer and moves its cursor to 0,0
+     putc/printf: Write at the cursor of the layer (from Stream)
+     draw:        Writes a character code at the cursor, as is
+     glyph:       Retrieves the character showing a bitmap
+     show:        Makes the layer visible
+     hide:        Hides the layer
+     visible:     Tells whether the layer is visible
+   Basic operations (LcdCompositor):
+     Constructor: Constructs a compositor of a TextLCD
+     run:         Renders the top layer whenever it changes (thread body)
+     render:      Renders the top layer if it changed since the last time
+     glyph:       Retrieves the character showing a bitmap
+     top:         Retrieves the priority of the layer on the panel
+   Class Invariant:
+      1. myLayers[p] is the layer of priority p, or 0
+      2. the TextLCD is only written by render()
+      3. the cells and the cursors of the layers and the slots are
+         guarded by myMutex
+-------------------------------------------------------------------------*/
+
+#ifndef LCDCOMPOSITOR
+#define LCDCOMPOSITOR
+
+#include "mbed.h"
+#include "rtos.h"
+#include "TextLCD.h"
+
+// The largest panel a layer can cover
+const int LCD_MAX_ROWS = 4;
+const int LCD_MAX_COLUMNS = 20;
+
+// The custom characters of the panel, shown by the codes from LCD_GLYPH
+const int LCD_GLYPHS = 8;
+const char LCD_GLYPH = 0;
+
+// The signal that wakes the thread running the compositor
+const int32_t COMPOSITOR_SIGNAL = 0x1;
+
+// The priorities of the layers, from the lowest
+enum LcdPriority {LAYER_STATUS, LAYER_MODAL, LAYER_EMERGENCY, LAYERS};
+
+class LcdCompositor;
+
+class LcdLayer : public Stream
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  LcdLayer(LcdCompositor & screen, LcdPriority priority,
+           bool visible = false);
+  /*-----------------------------------------------------------------------
+    Construct a LcdLayer object.
+
+    Precondition:  No other layer of screen has this priority.
+    Postcondition: A blank layer with its cursor at 0,0 has been added to
+        screen.
+   ----------------------------------------------------------------------*/
+
+  void locate(int column, int row);
+  /*-----------------------------------------------------------------------
+    Move the cursor of the layer to a column and a row, from 0.
+   ----------------------------------------------------------------------*/
+
+  void cls();
+  /*-----------------------------------------------------------------------
+    Blank the layer and move its cursor to 0,0 (nothing is sent to the
+    panel until the layer is rendered).
+   ----------------------------------------------------------------------*/
+
+  void draw(char code);
+  /*-----------------------------------------------------------------------
+    Write a character code at the cursor of the layer and move the cursor
+    to the next cell.
+
+    Precondition:  None.
+    Postcondition: The cell shows code, even a glyph or another code putc()
+        takes for a control character (e.g. '\n').
+   ----------------------------------------------------------------------*/
+
+  char glyph(const char * bitmap);
+  /*-----------------------------------------------------------------------
+    Retrieve the character showing a bitmap (see LcdCompositor::glyph()),
+    to be written with draw().
+   ----------------------------------------------------------------------*/
+
+  void show();
+  /*-----------------------------------------------------------------------
+    Make the layer visible; it is rendered if no visible layer is above.
+   ----------------------------------------------------------------------*/
+
+  void hide();
+  /*-----------------------------------------------------------------------
+    Hide the layer; the visible layer below it is rendered instead.
+   ----------------------------------------------------------------------*/
+
+  bool visible() const;
+  /*-----------------------------------------------------------------------
+    Tell whether the layer is visible.
+   ----------------------------------------------------------------------*/
+
+ protected:
+  // Stream implementation functions
+  virtual int _putc(int value);
+  virtual int _getc();
+
+ private:
+  friend class LcdCompositor;
+  void store(char code);
+
+  /***** Data Members *****/
+  LcdCompositor & myScreen;
+  int myPriority;
+  int myRows;
+  int myColumns;
+  char myCells[LCD_MAX_ROWS][LCD_MAX_COLUMNS];
+  int myColumn;
+  int myRow;
+  bool isVisible;
+}; // end of class declaration
+
+class LcdCompositor
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  LcdCompositor(TextLCD & lcd);
+  /*-----------------------------------------------------------------------
+    Construct a LcdCompositor object.
+
+    Precondition:  Nothing else writes to lcd once run() has started.
+    Postcondition: A compositor without layers has been constructed.
+   ----------------------------------------------------------------------*/
+
+  void run();
+  /*-----------------------------------------------------------------------
+    Render the top layer whenever it changes; never returns.
+
+    Precondition:  Called by the thread that owns the TextLCD.
+    Postcondition: None (the thread sleeps between changes).
+   ----------------------------------------------------------------------*/
+
+  bool render();
+  /*-----------------------------------------------------------------------
+    Render the top layer if it changed.
+
+    Precondition:  Called by the thread that owns the TextLCD.
+    Postcondition: If the top visible layer is another one or has changed
+        since the last render, it has been written to the TextLCD (which
+        sends only the cells that differ) and true is returned.
+   ----------------------------------------------------------------------*/
+
+  int top();
+  /*-----------------------------------------------------------------------
+    Retrieve the priority of the layer rendered last, -1 if none.
+   ----------------------------------------------------------------------*/
+
+  char glyph(const char * bitmap);
+  /*-----------------------------------------------------------------------
+    Retrieve the character showing a bitmap.
+
+    Precondition:  bitmap holds 8 rows of 5 pixels (bit 4 on the left),
+        the top one first.
+    Postcondition: The character (LCD_GLYPH to LCD_GLYPH + LCD_GLYPHS - 1)
+        of the slot holding bitmap is returned. If no slot held it, the
+        least recently requested slot now does, and the panel is rendered
+        again with it.
+   ----------------------------------------------------------------------*/
+
+ private:
+  friend class LcdLayer;
+  void changed(LcdLayer * layer, bool shown);
+  void wake();
+
+  /***** Data Members *****/
+  TextLCD & myLcd;
+  LcdLayer * myLayers[LAYERS];
+  Mutex myMutex;
+  osThreadId myOwner;
+  int myShown;
+  bool isDirty;
+  // the bitmaps of the slots, and when each was last requested (0: never)
+  char myGlyphs[LCD_GLYPHS][8];
+  uint32_t myGlyphUse[LCD_GLYPHS];
+  uint32_t myClock;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,79 @@
+/*-- LcdWidgets.cpp--------------------------------------------------------
+             This file implements the graphs drawn on the LCD.
+-------------------------------------------------------------------------*/
+
+#include "LcdWidgets.h"
+
+// The character of the ROM lighting every pixel of a cell
+static const char FULL_CELL = (char)0xFF;
+
+//--- Definition of sparkline()
+void sparkline(LcdLayer & layer, const HistoryBucket * buckets, int count,
+               centi_t span)
+{
+    // the range of the means, at least span wide around them
+    centi_t low = 0, high = 0;
+    bool any = false;
+    for(int i = 0; i < count; i++)
+    {
+        if(buckets[i].count == 0)
+            continue;
+        centi_t mean = buckets[i].mean();
+        if(!any || mean < low)
+            low = mean;
+        if(!any || mean > high)
+            high = mean;
+        any = true;
+    }
+    if(high - low < span)
+    {
+        low -= (span - (high - low)) / 2;
+        high = low + span;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        if(buckets[i].count == 0)
+        {
+            layer.draw(' ');
+            continue;
+        }
+        // 1 (the lowest mean) to SPARK_LEVELS (the highest) rows lit
+        int level = 1 + (int)((int64_t)(buckets[i].mean() - low)
+                              * (SPARK_LEVELS - 1) * 2 / (high - low) + 1) / 2;
+        if(level >= SPARK_LEVELS)
+        {
+            layer.draw(FULL_CELL);
+            continue;
+        }
+        char bitmap[8];
+        for(int row = 0; row < 8; row++)
+            bitmap[row] = row >= SPARK_LEVELS - level ? 0x1F : 0;
+        layer.draw(layer.glyph(bitmap));
+    }
+}
+
+//--- Definition of bar()
+void bar(LcdLayer & layer, float fraction, int width)
+{
+    if(fraction < 0)
+        fraction = 0;
+    if(fraction > 1)
+        fraction = 1;
+    int pixels = (int)(fraction * width * BAR_PIXELS + 0.5f);
+    for(int i = 0; i < width; i++, pixels -= BAR_PIXELS)
+    {
+        if(pixels >= BAR_PIXELS)
+            layer.draw(FULL_CELL);
+        else if(pixels <= 0)
+            layer.draw(' ');
+        else
+        {
+            // the leftmost columns of the cell
+            char bitmap[8];
+            for(int row = 0; row < 8; row++)
+                bitmap[row] = (0x1F << (BAR_PIXELS - pixels)) & 0x1F;
+            layer.draw(layer.glyph(bitmap));
+        }
+    }
+}
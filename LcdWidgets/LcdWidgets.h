@@ -0,0 +1,53 @@
+/* LcdWidgets.h contains the declarations of the graphs drawn on a layer
+   of the LCD with custom characters.
+   A sparkline draws one cell per bucket of a TempHistory: a bar rising
+   from the bottom of the cell to the mean of the bucket, in 8 steps over
+   the range of the buckets drawn. A bar graph draws a fraction (e.g. the
+   duty of the fan) as a horizontal bar of 5 pixels a cell. Both use the
+   full block of the character ROM (0xFF) for a full cell and a space for
+   an empty one, and custom characters in between: at most 7 for a
+   sparkline and 1 for a bar graph, so both fit the 8 slots of the panel
+   together. The bitmaps are requested from the compositor through the
+   layer, which uploads a slot only when its bitmap changes, and a cell
+   goes on the bus only when its character changes. The cells are
+   written with LcdLayer::draw(), as the glyphs are the codes 0-7.
+   Basic operations:
+     sparkline:   Draws buckets as a sparkline at the cursor of a layer
+     bar:         Draws a fraction as a bar graph at the cursor of a layer
+-------------------------------------------------------------------------*/
+
+#ifndef LCDWIDGETS
+#define LCDWIDGETS
+
+#include "TempFixed.h"
+#include "TempHistory.h"
+#include "LcdCompositor.h"
+
+// The heights of a sparkline cell, and the pixels across a bar cell
+const int SPARK_LEVELS = 8;
+const int BAR_PIXELS = 5;
+
+void sparkline(LcdLayer & layer, const HistoryBucket * buckets, int count,
+               centi_t span = 100);
+/*-------------------------------------------------------------------------
+  Draw a sparkline.
+
+  Precondition:  buckets holds count buckets, the oldest first; span > 0
+      is the smallest range (centi-degrees) the cells are scaled to, so
+      the noise of a steady temperature is not magnified.
+  Postcondition: count cells have been written at the cursor of layer:
+      a space for an empty bucket, otherwise a bar of 1 to SPARK_LEVELS
+      eighths of the cell from the lowest to the highest mean.
+ ------------------------------------------------------------------------*/
+
+void bar(LcdLayer & layer, float fraction, int width);
+/*-------------------------------------------------------------------------
+  Draw a bar graph.
+
+  Precondition:  fraction is between 0 and 1 (clamped otherwise).
+  Postcondition: width cells have been written at the cursor of layer,
+      filled from the left over fraction of their width * BAR_PIXELS
+      pixels, rounded to the nearest pixel.
+ ------------------------------------------------------------------------*/
+
+#endif
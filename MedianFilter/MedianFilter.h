@@ -0,0 +1,276 @@
+/* MedianFilter.h contains the declaration and the implementation of the
+   class template MedianFilter.
+   A sliding-window median over the last N readings, used to reject the
+   single-reading spikes (ADC glitches) before they reach the outputs and
+   the averaging queue.
+   The window is kept in a ring and ordered by a max-heap (the lower half)
+   and a min-heap (the upper half) sharing one array around the median,
+   with the heap position of every ring slot tracked. Replacing the oldest
+   reading only sifts that slot up or down its heap: O(log N) per reading,
+   nothing is re-sorted and no memory is allocated.
+   Modes:
+     MEDIAN_OUTPUT: every reading is replaced by the window's median
+     SPIKE_REJECT:  a reading passes unchanged unless it is further than
+                    the limit from the median of the window (including
+                    itself); it is then replaced by that median
+   Basic operations:
+     Constructor: Constructs an empty window with a mode and a limit
+     filter:      Adds a reading and returns the filtered value
+     median:      Retrieves the median of the window
+     size:        Retrieves the number of readings in the window
+     rejected:    Retrieves the number of readings replaced so far
+   Class Invariant:
+      1. heap[0] is the median slot; heap[-maxCount()..-1] is a max-heap of
+         readings <= median, heap[1..minCount()] a min-heap of readings >=
+         median (heap indices of the children of i are 2i and 2i +/- 1)
+      2. pos[heap[i]] == i for every used heap position i
+      3. 1 <= N <= 255
+-------------------------------------------------------------------------*/
+
+#ifndef MEDIANFILTER
+#define MEDIANFILTER
+
+#include <stdint.h>
+
+enum MedianMode
+{
+    MEDIAN_OUTPUT,
+    SPIKE_REJECT
+};
+
+template <typename T, int N>
+class MedianFilter
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  MedianFilter(MedianMode mode = SPIKE_REJECT, T limit = T());
+  /*-----------------------------------------------------------------------
+    Construct a MedianFilter object.
+
+    Precondition:  limit >= 0 (only used in SPIKE_REJECT mode).
+    Postcondition: An empty window of N readings has been constructed.
+   ----------------------------------------------------------------------*/
+
+  T filter(T value);
+  /*-----------------------------------------------------------------------
+    Add a reading to the window and filter it.
+
+    Precondition:  None.
+    Postcondition: value replaces the oldest reading once the window is
+        full; the filtered value (see Modes) is returned.
+   ----------------------------------------------------------------------*/
+
+  T median() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the median of the window.
+
+    Precondition:  The window is nonempty.
+    Postcondition: The middle reading (mean of the middle two for an even
+        count) is returned.
+   ----------------------------------------------------------------------*/
+
+  int size() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of readings in the window (at most N).
+   ----------------------------------------------------------------------*/
+
+  unsigned rejected() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of readings replaced by the median so far.
+   ----------------------------------------------------------------------*/
+
+  void set_mode(MedianMode mode, T limit);
+  /*-----------------------------------------------------------------------
+    Change the mode and the spike limit; the window is kept.
+   ----------------------------------------------------------------------*/
+
+ private:
+  // not copyable: heap points into the object's own storage
+  MedianFilter(const MedianFilter &);
+  MedianFilter & operator=(const MedianFilter &);
+
+  int minCount() const { return (count - 1) / 2; }
+  int maxCount() const { return count / 2; }
+  bool less(int i, int j) const { return data[heap[i]] < data[heap[j]]; }
+  bool exchange(int i, int j);
+  bool lessExchange(int i, int j) { return less(i, j) && exchange(i, j); }
+  void minSortDown(int i);
+  void maxSortDown(int i);
+  bool minSortUp(int i);
+  bool maxSortUp(int i);
+
+  /***** Data Members *****/
+  T data[N];
+  int16_t pos[N];
+  int16_t storage[N];
+  // points to the median position in the middle of storage
+  int16_t * heap;
+  int index;
+  int count;
+  MedianMode myMode;
+  T myLimit;
+  unsigned myRejected;
+}; // end of class declaration
+
+//--- Definition of MedianFilter constructor
+template <typename T, int N>
+MedianFilter<T, N>::MedianFilter(MedianMode mode, T limit)
+{
+    heap = storage + N / 2;
+    index = 0;
+    count = 0;
+    myMode = mode;
+    myLimit = limit;
+    myRejected = 0;
+    // initial slot pattern around the median: median, max, min, max, ...
+    for(int i = N - 1; i >= 0; i--)
+    {
+        pos[i] = ((i + 1) / 2) * ((i & 1) ? -1 : 1);
+        heap[pos[i]] = i;
+        data[i] = T();
+    }
+}
+
+//--- Definition of filter()
+template <typename T, int N>
+T MedianFilter<T, N>::filter(T value)
+{
+    bool grows = count < N;
+    int p = pos[index];
+    T old = data[index];
+    data[index] = value;
+    index = (index + 1) % N;
+    if(grows)
+        count++;
+
+    if(p > 0)
+    {
+        // the slot is in the min-heap
+        if(!grows && old < value)
+            minSortDown(p * 2);
+        else if(minSortUp(p))
+            maxSortDown(-1);
+    }
+    else if(p < 0)
+    {
+        // the slot is in the max-heap
+        if(!grows && value < old)
+            maxSortDown(p * 2);
+        else if(maxSortUp(p))
+            minSortDown(1);
+    }
+    else
+    {
+        // the slot is the median itself
+        if(maxCount())
+            maxSortDown(-1);
+        if(minCount())
+            minSortDown(1);
+    }
+
+    T middle = median();
+    if(myMode == MEDIAN_OUTPUT)
+    {
+        if(middle != value)
+            myRejected++;
+        return middle;
+    }
+    T deviation = value < middle ? middle - value : value - middle;
+    if(myLimit < deviation)
+    {
+        myRejected++;
+        return middle;
+    }
+    return value;
+}
+
+//--- Definition of median()
+template <typename T, int N>
+T MedianFilter<T, N>::median() const
+{
+    T value = data[heap[0]];
+    if((count & 1) == 0)
+        value = (value + data[heap[-1]]) / 2;
+    return value;
+}
+
+//--- Definition of size()
+template <typename T, int N>
+int MedianFilter<T, N>::size() const
+{
+    return count;
+}
+
+//--- Definition of rejected()
+template <typename T, int N>
+unsigned MedianFilter<T, N>::rejected() const
+{
+    return myRejected;
+}
+
+//--- Definition of set_mode()
+template <typename T, int N>
+void MedianFilter<T, N>::set_mode(MedianMode mode, T limit)
+{
+    myMode = mode;
+    myLimit = limit;
+}
+
+//--- Definition of exchange()
+template <typename T, int N>
+bool MedianFilter<T, N>::exchange(int i, int j)
+{
+    int16_t t = heap[i];
+    heap[i] = heap[j];
+    heap[j] = t;
+    pos[heap[i]] = i;
+    pos[heap[j]] = j;
+    return true;
+}
+
+//--- Definition of minSortDown(): restores the min-heap from i / 2 down
+template <typename T, int N>
+void MedianFilter<T, N>::minSortDown(int i)
+{
+    for(; i <= minCount(); i *= 2)
+    {
+        if(i > 1 && i < minCount() && less(i + 1, i))
+            ++i;
+        if(!lessExchange(i, i / 2))
+            break;
+    }
+}
+
+//--- Definition of maxSortDown(): restores the max-heap from i / 2 down
+template <typename T, int N>
+void MedianFilter<T, N>::maxSortDown(int i)
+{
+    for(; i >= -maxCount(); i *= 2)
+    {
+        if(i < -1 && i > -maxCount() && less(i, i - 1))
+            --i;
+        if(!lessExchange(i / 2, i))
+            break;
+    }
+}
+
+//--- Definition of minSortUp(): true if the value reached the median
+template <typename T, int N>
+bool MedianFilter<T, N>::minSortUp(int i)
+{
+    while(i > 0 && lessExchange(i, i / 2))
+        i /= 2;
+    return i == 0;
+}
+
+//--- Definition of maxSortUp(): true if the value reached the median
+template <typename T, int N>
+bool MedianFilter<T, N>::maxSortUp(int i)
+{
+    while(i < 0 && lessExchange(i / 2, i))
+        i /= 2;
+    return i == 0;
+}
+
+#endif
@@ -0,0 +1,172 @@
+/*-- RelayTuner.cpp--------------------------------------------------------
+             This file implements RelayTuner member functions.
+-------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "RelayTuner.h"
+
+// Rounds a gain to the Q16 of FanPid, within an int32_t
+static int32_t to_gain(float gain)
+{
+    if(gain <= 0)
+        return 0;
+    if(gain >= 2147483647.0f)
+        return 2147483647;
+    return (int32_t)(gain + 0.5f);
+}
+
+//--- Definition of RelayTuner constructor
+RelayTuner::RelayTuner(centi_t hysteresis, int cycles, uint32_t timeout_s)
+{
+    myHysteresis = hysteresis;
+    myCount = cycles;
+    myTimeout = timeout_s * 1000;
+    myState = TUNE_IDLE;
+    mySetpoint = 0;
+    myHigh = PID_ONE;
+    myLow = 0;
+    isHigh = false;
+    primed = false;
+    myTime = 0;
+    myCycleStart = -1;
+    myMax = myMin = 0;
+    myCycles = 0;
+    myPeriods = 0;
+    myAmplitudes = 0;
+}
+
+//--- Definition of start()
+void RelayTuner::start(centi_t setpoint, int32_t high, int32_t low)
+{
+    mySetpoint = setpoint;
+    myHigh = high;
+    myLow = low;
+    myTime = 0;
+    myCycleStart = -1;
+    myCycles = 0;
+    myPeriods = 0;
+    myAmplitudes = 0;
+    // the relay takes its side at the first measurement
+    primed = false;
+    myState = TUNE_RUNNING;
+}
+
+//--- Definition of stop()
+void RelayTuner::stop()
+{
+    if(myState == TUNE_RUNNING)
+        myState = TUNE_FAILED;
+}
+
+//--- Definition of update()
+int32_t RelayTuner::update(centi_t measured, uint32_t dt_ms)
+{
+    if(myState != TUNE_RUNNING)
+        return myLow;
+    myTime += dt_ms;
+    if(myTime > myTimeout)
+    {
+        // the enclosure did not oscillate around the setpoint
+        myState = TUNE_FAILED;
+        return myLow;
+    }
+    if(!primed)
+    {
+        isHigh = measured > mySetpoint;
+        primed = true;
+    }
+
+    // the peaks of the current cycle
+    if(measured > myMax)
+        myMax = measured;
+    if(measured < myMin)
+        myMin = measured;
+
+    if(isHigh && measured < mySetpoint - myHysteresis)
+        isHigh = false;
+    else if(!isHigh && measured > mySetpoint + myHysteresis)
+    {
+        // a cycle runs from one switch to the high duty to the next
+        isHigh = true;
+        if(myCycleStart >= 0)
+        {
+            if(++myCycles > TUNE_SKIP_CYCLES)
+            {
+                myPeriods += myTime - myCycleStart;
+                myAmplitudes += (myMax - myMin) / 2;
+            }
+            if(myCycles == myCount + TUNE_SKIP_CYCLES)
+                myState = TUNE_DONE;
+        }
+        myCycleStart = myTime;
+        myMax = myMin = measured;
+    }
+    if(myState == TUNE_DONE)
+        return myLow;
+    return isHigh ? myHigh : myLow;
+}
+
+//--- Definition of state()
+TuneState RelayTuner::state() const
+{
+    return myState;
+}
+
+//--- Definition of cycles()
+int RelayTuner::cycles() const
+{
+    return myCycles > TUNE_SKIP_CYCLES ? myCycles - TUNE_SKIP_CYCLES : 0;
+}
+
+//--- Definition of total()
+int RelayTuner::total() const
+{
+    return myCount;
+}
+
+//--- Definition of period()
+uint32_t RelayTuner::period() const
+{
+    int measured = cycles();
+    return measured ? (uint32_t)(myPeriods / measured) : 0;
+}
+
+//--- Definition of amplitude()
+centi_t RelayTuner::amplitude() const
+{
+    int measured = cycles();
+    return measured ? (centi_t)(myAmplitudes / measured) : 0;
+}
+
+//--- Definition of gains()
+PidGains RelayTuner::gains(TuneRule rule) const
+{
+    PidGains gains = { 0, 0, 0 };
+    float a = amplitude() / 100.0f;
+    float e = myHysteresis / 100.0f;
+    float pu = period() / 1000.0f;
+    if(a <= 0 || pu <= 0)
+        return gains;
+    // the ultimate gain, in Q16 duty per degree; the hysteresis correction
+    // is left out if the oscillation is not clearly wider than it
+    float d = (myHigh - myLow) / 2.0f;
+    float r = a > e * 1.1f ? sqrtf(a * a - e * e) : a;
+    float ku = 4 * d / (3.14159265f * r);
+    float kp, ti, td;
+    if(rule == TUNE_TYREUS_LUYBEN)
+    {
+        kp = ku / 2.2f;
+        ti = 2.2f * pu;
+        td = pu / 6.3f;
+    }
+    else
+    {
+        kp = 0.6f * ku;
+        ti = pu / 2;
+        td = pu / 8;
+    }
+    gains.kp = to_gain(kp);
+    gains.ki = to_gain(kp / ti);
+    gains.kd = to_gain(kp * td);
+    return gains;
+}
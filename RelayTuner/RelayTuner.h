@@ -0,0 +1,156 @@
+/* RelayTuner.h contains the declaration of class RelayTuner.
+   Relay-feedback (Astrom-Hagglund) auto-tuning of the fan controller.
+   While it runs, the tuner drives the fan itself as a relay: the high
+   duty once the temperature is above the setpoint by the hysteresis,
+   the low duty once it is below it by the hysteresis. The enclosure
+   then oscillates around the setpoint. From the period Pu and the
+   amplitude a of the oscillation, with d half the difference of the
+   duties and e the hysteresis, the ultimate gain is
+       Ku = 4 d / (pi * sqrt(a^2 - e^2))
+   and the gains of a FanPid follow from a tuning rule (Ziegler-Nichols
+   or the less aggressive Tyreus-Luyben). The first cycles are discarded
+   while the oscillation builds up; the period and the amplitude are
+   averaged over the cycles after them.
+   Like FanPid, time only advances through the dt_ms passed in, so the
+   tuner runs the same on the board or against a simulated plant.
+   Basic operations:
+     Constructor: Constructs an idle tuner
+     start:       Starts an experiment around a setpoint
+     stop:        Abandons the experiment
+     update:      Computes the relay duty for a new measurement
+     state:       Retrieves the state of the experiment
+     cycles:      Retrieves how many cycles were completed
+     total:       Retrieves how many cycles the experiment measures
+     period:      Retrieves the measured period of the oscillation
+     amplitude:   Retrieves the measured amplitude of the oscillation
+     gains:       Retrieves the gains of a tuning rule
+   Class Invariant:
+      1. myCycles <= myCount + TUNE_SKIP_CYCLES
+      2. the experiment runs only while myState is TUNE_RUNNING
+-------------------------------------------------------------------------*/
+
+#ifndef RELAYTUNER
+#define RELAYTUNER
+
+#include <stdint.h>
+#include "TempFixed.h"
+#include "FanPid.h"
+
+// The states of an experiment
+enum TuneState {TUNE_IDLE, TUNE_RUNNING, TUNE_DONE, TUNE_FAILED};
+
+// The rules turning the oscillation into gains
+enum TuneRule {TUNE_ZIEGLER_NICHOLS, TUNE_TYREUS_LUYBEN};
+
+// The number of cycles discarded before measuring
+const int TUNE_SKIP_CYCLES = 1;
+
+class RelayTuner
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  RelayTuner(centi_t hysteresis = 20, int cycles = 3,
+             uint32_t timeout_s = 7200);
+  /*-----------------------------------------------------------------------
+    Construct a RelayTuner object.
+
+    Precondition:  hysteresis (centi-degrees) is above the noise of the
+        readings; cycles > 0 is the number of cycles measured after the
+        TUNE_SKIP_CYCLES first ones; timeout_s is the longest experiment.
+    Postcondition: An idle tuner has been constructed.
+   ----------------------------------------------------------------------*/
+
+  void start(centi_t setpoint, int32_t high = PID_ONE, int32_t low = 0);
+  /*-----------------------------------------------------------------------
+    Start an experiment.
+
+    Precondition:  0 <= low < high <= PID_ONE are the relay duties (Q16);
+        the fan at high cools the enclosure below setpoint and at low
+        lets it warm above it.
+    Postcondition: The previous results are forgotten and the state is
+        TUNE_RUNNING.
+   ----------------------------------------------------------------------*/
+
+  void stop();
+  /*-----------------------------------------------------------------------
+    Abandon the experiment.
+
+    Precondition:  None.
+    Postcondition: A running experiment is TUNE_FAILED; the state is
+        unchanged otherwise.
+   ----------------------------------------------------------------------*/
+
+  int32_t update(centi_t measured, uint32_t dt_ms);
+  /*-----------------------------------------------------------------------
+    Compute the relay duty for a new measurement.
+
+    Precondition:  dt_ms is the time since the previous update.
+    Postcondition: While TUNE_RUNNING, the measurement has been taken into
+        the peaks and the cycles, and the duty (Q16) to apply is returned.
+        The state becomes TUNE_DONE once the cycles are measured, or
+        TUNE_FAILED at the timeout. Otherwise the low duty is returned.
+   ----------------------------------------------------------------------*/
+
+  TuneState state() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the state of the experiment.
+   ----------------------------------------------------------------------*/
+
+  int cycles() const;
+  /*-----------------------------------------------------------------------
+    Retrieve how many measured cycles were completed (0 - the cycles
+    given to the constructor), not counting the discarded ones.
+   ----------------------------------------------------------------------*/
+
+  int total() const;
+  /*-----------------------------------------------------------------------
+    Retrieve how many cycles the experiment measures.
+   ----------------------------------------------------------------------*/
+
+  uint32_t period() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the mean period (ms) of the measured cycles, 0 if none.
+   ----------------------------------------------------------------------*/
+
+  centi_t amplitude() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the mean amplitude (half the peak-to-peak, centi-degrees) of
+    the measured cycles, 0 if none.
+   ----------------------------------------------------------------------*/
+
+  PidGains gains(TuneRule rule) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the gains of a tuning rule.
+
+    Precondition:  state() is TUNE_DONE.
+    Postcondition: The FanPid gains of rule for the measured oscillation
+        are returned; all zero if no cycle was measured.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  centi_t myHysteresis;
+  int myCount;
+  uint32_t myTimeout;
+  TuneState myState;
+  centi_t mySetpoint;
+  int32_t myHigh;
+  int32_t myLow;
+  // whether the relay is at the high duty, and took its side yet
+  bool isHigh;
+  bool primed;
+  // ms since start, and at the start of the current cycle (-1: none yet)
+  uint32_t myTime;
+  int64_t myCycleStart;
+  // peaks of the current cycle
+  centi_t myMax;
+  centi_t myMin;
+  // cycles completed, including the discarded ones
+  int myCycles;
+  // sums of the measured cycles
+  uint64_t myPeriods;
+  int64_t myAmplitudes;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,155 @@
+/* SampleChannel.h contains the declaration and the implementation of the
+   class template SampleChannel.
+   A ring of N values passed from exactly one producer (thread or
+   interrupt) to exactly one consumer, without locks or critical
+   sections. It follows mbed's CircularBuffer, but each index is written
+   by one side only: the producer owns myHead, the consumer owns myTail,
+   and a memory barrier orders the value before the index that publishes
+   it. Unlike CircularBuffer, a full channel does not overwrite: the new
+   value is dropped and counted, so a consumer falling behind is seen
+   instead of silently losing (or repeating) values.
+   Basic operations:
+     Constructor: Constructs an empty channel
+     push:        Producer: adds a value at the back
+     pop:         Consumer: removes the value at the front
+     empty:       Checks if a channel is empty
+     size:        Retrieves the number of values waiting
+     overflows:   Retrieves the number of values dropped on a full channel
+   Class Invariant:
+      1. 0 <= myHead - myTail <= N (indices run freely and wrap together)
+      2. N is a power of 2
+-------------------------------------------------------------------------*/
+
+#ifndef SAMPLECHANNEL
+#define SAMPLECHANNEL
+
+#if defined(TARGET_STM32F4)
+#include "mbed.h"
+#define CHANNEL_BARRIER() __DMB()
+#else
+#include <stdint.h>
+#define CHANNEL_BARRIER() __sync_synchronize()
+#endif
+
+template <typename T, uint32_t N>
+class SampleChannel
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  SampleChannel();
+  /*-----------------------------------------------------------------------
+    Construct a SampleChannel object.
+
+    Precondition:  None.
+    Postcondition: An empty channel for N values has been constructed.
+   ----------------------------------------------------------------------*/
+
+  bool push(const T & value);
+  /*-----------------------------------------------------------------------
+    Add a value to the channel. Only the producer may call it.
+
+    Precondition:  None.
+    Postcondition: Returns true with value added at the back; returns
+        false and counts an overflow if the channel was full.
+   ----------------------------------------------------------------------*/
+
+  bool pop(T & value);
+  /*-----------------------------------------------------------------------
+    Remove the front value of the channel. Only the consumer may call it.
+
+    Precondition:  None.
+    Postcondition: Returns true with the front value moved to value;
+        returns false if the channel was empty.
+   ----------------------------------------------------------------------*/
+
+  bool empty() const;
+  /*-----------------------------------------------------------------------
+    Check if the channel is empty.
+   ----------------------------------------------------------------------*/
+
+  uint32_t size() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of values waiting in the channel.
+   ----------------------------------------------------------------------*/
+
+  uint32_t overflows() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of values dropped because the channel was full.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  T myPool[N];
+  volatile uint32_t myHead;
+  volatile uint32_t myTail;
+  volatile uint32_t myOverflows;
+}; // end of class declaration
+
+//--- Definition of SampleChannel constructor
+template <typename T, uint32_t N>
+SampleChannel<T, N>::SampleChannel()
+{
+    // the indices are masked with N - 1
+    typedef char power_of_two[(N & (N - 1)) == 0 ? 1 : -1];
+    (void)sizeof(power_of_two);
+    myHead = 0;
+    myTail = 0;
+    myOverflows = 0;
+}
+
+//--- Definition of push()
+template <typename T, uint32_t N>
+bool SampleChannel<T, N>::push(const T & value)
+{
+    uint32_t head = myHead;
+    if(head - myTail == N)
+    {
+        myOverflows++;
+        return false;
+    }
+    myPool[head & (N - 1)] = value;
+    // the value must be complete before the consumer can see it
+    CHANNEL_BARRIER();
+    myHead = head + 1;
+    return true;
+}
+
+//--- Definition of pop()
+template <typename T, uint32_t N>
+bool SampleChannel<T, N>::pop(T & value)
+{
+    uint32_t tail = myTail;
+    if(myHead == tail)
+        return false;
+    // read the value only after seeing the index that published it
+    CHANNEL_BARRIER();
+    value = myPool[tail & (N - 1)];
+    // the value must be copied before the producer can reuse its slot
+    CHANNEL_BARRIER();
+    myTail = tail + 1;
+    return true;
+}
+
+//--- Definition of empty()
+template <typename T, uint32_t N>
+bool SampleChannel<T, N>::empty() const
+{
+    return myHead == myTail;
+}
+
+//--- Definition of size()
+template <typename T, uint32_t N>
+uint32_t SampleChannel<T, N>::size() const
+{
+    return myHead - myTail;
+}
+
+//--- Definition of overflows()
+template <typename T, uint32_t N>
+uint32_t SampleChannel<T, N>::overflows() const
+{
+    return myOverflows;
+}
+
+#endif
@@ -0,0 +1,229 @@
+/* SensorTable.h contains the sensor transfer functions and the class
+   template SensorTable that turns one of them into a lookup table.
+   A transfer function maps the fraction of the ADC full scale (0 - 1) to
+   degrees Celsius. SensorTable samples it at 2^Bits + 1 evenly spaced
+   read_u16() codes; converting a reading is then one table lookup and
+   one linear interpolation in integer arithmetic, with no libm call.
+   When compiled as C++11 the table is generated by the compiler (the
+   transfer functions and the math they use are constexpr). The firmware
+   is built as gnu++98: on the board each table is computed at run time,
+   once before main() runs, in software double precision (the Cortex-M4F
+   has single-precision hardware only). No libm call is made either way.
+   Sensors:
+     Lm35Sensor:   10 mV/C output, TEMP_FULL_SCALE degrees at full scale
+     NtcSensor:    NTC thermistor (Beta model) at the bottom of a divider
+     Pt100Sensor:  PT100 behind a front-end mapping RLow - RHigh milliohms
+                   linearly onto the ADC span (Callendar-Van Dusen, T >= 0)
+   Basic operations:
+     SensorTable<Sensor, Bits>::convert: read_u16() code to centi-degrees
+     SensorTable<Sensor, Bits>::entry:   exact table value at an index
+-------------------------------------------------------------------------*/
+
+#ifndef SENSORTABLE
+#define SENSORTABLE
+
+#include "TempFixed.h"
+
+#if __cplusplus >= 201103L
+#define SENSOR_CONSTEXPR constexpr
+#define SENSOR_CONST constexpr
+#else
+#define SENSOR_CONSTEXPR inline
+#define SENSOR_CONST const
+#endif
+
+/***** Compile-time math (no libm) *****/
+namespace sensor_math
+{
+// Euler's number
+SENSOR_CONST double E = 2.71828182845904523536;
+// 0 degrees Celsius in Kelvin
+SENSOR_CONST double KELVIN = 273.15;
+
+// 2 * sum of y^n / n for odd n: ln((1 + y) / (1 - y)) for small |y|
+SENSOR_CONSTEXPR double ln_series(double y2, double term, int n)
+{
+    return n > 41 ? 0 : term / n + ln_series(y2, term * y2, n + 2);
+}
+
+// natural logarithm of x > 0, reduced to [0.5, 2] by powers of e
+SENSOR_CONSTEXPR double ln(double x)
+{
+    return x > 2 ? ln(x / E) + 1
+         : x < 0.5 ? ln(x * E) - 1
+         : 2 * ln_series(((x - 1) / (x + 1)) * ((x - 1) / (x + 1)),
+                         (x - 1) / (x + 1), 1);
+}
+
+// Newton iterations of the square root of x, starting from guess
+SENSOR_CONSTEXPR double sqrt_newton(double x, double guess, int n)
+{
+    return n == 0 ? guess : sqrt_newton(x, (guess + x / guess) / 2, n - 1);
+}
+
+// square root of x >= 0
+SENSOR_CONSTEXPR double sqrt(double x)
+{
+    return x <= 0 ? 0 : sqrt_newton(x, x > 1 ? x : 1, 40);
+}
+
+// keeps the fraction away from 0 and 1 where R (and ln R) diverge
+SENSOR_CONSTEXPR double clamp_fraction(double x)
+{
+    return x < 0.5 / 65536 ? 0.5 / 65536
+         : x > 1 - 0.5 / 65536 ? 1 - 0.5 / 65536 : x;
+}
+
+// degrees Celsius rounded to centi-degrees, limited to +-1000C
+SENSOR_CONSTEXPR centi_t to_centi(double celsius)
+{
+    return celsius > 1000 ? 100000
+         : celsius < -1000 ? -100000
+         : (centi_t)(celsius * 100 + (celsius < 0 ? -0.5 : 0.5));
+}
+} // namespace sensor_math
+
+/***** Transfer functions *****/
+
+// LM35: 10 mV per degree, TEMP_FULL_SCALE degrees at full scale
+struct Lm35Sensor
+{
+    static SENSOR_CONSTEXPR double celsius(double x)
+    {
+        return x * TEMP_FULL_SCALE;
+    }
+};
+
+// NTC thermistor of R0 ohms at 25C with the given Beta (K), at the bottom
+// of a divider whose top resistor is RFixed ohms
+template <int R0, int Beta, int RFixed>
+struct NtcSensor
+{
+    static SENSOR_CONSTEXPR double resistance(double x)
+    {
+        return (double)RFixed * x / (1 - x);
+    }
+    static SENSOR_CONSTEXPR double celsius(double x)
+    {
+        return 1 / (1 / (25 + sensor_math::KELVIN)
+                    + sensor_math::ln(resistance(
+                          sensor_math::clamp_fraction(x)) / R0) / Beta)
+               - sensor_math::KELVIN;
+    }
+};
+
+// PT100 (IEC 60751) behind a front-end mapping RLow - RHigh milliohms
+// linearly onto the ADC span
+template <int RLow, int RHigh>
+struct Pt100Sensor
+{
+    static SENSOR_CONSTEXPR double resistance(double x)
+    {
+        return (RLow + (double)(RHigh - RLow) * x) / 1000;
+    }
+    // inverse of R = 100 (1 + A T + B T^2) for T >= 0
+    static SENSOR_CONSTEXPR double solve(double r)
+    {
+        return (-3.9083e-3 + sensor_math::sqrt(3.9083e-3 * 3.9083e-3
+                 - 4 * -5.775e-7 * (1 - r / 100))) / (2 * -5.775e-7);
+    }
+    static SENSOR_CONSTEXPR double celsius(double x)
+    {
+        return solve(resistance(x));
+    }
+};
+
+/***** Lookup table *****/
+
+// the table value at index i of a table with 2^Bits intervals
+template <class Sensor, int Bits>
+SENSOR_CONSTEXPR centi_t sensor_entry(int i)
+{
+    return sensor_math::to_centi(Sensor::celsius((double)i / (1 << Bits)));
+}
+
+#if __cplusplus >= 201103L
+template <int... I> struct SensorIndices {};
+template <int N, int... I>
+struct SensorMakeIndices : SensorMakeIndices<N - 1, N - 1, I...> {};
+template <int... I>
+struct SensorMakeIndices<0, I...> { typedef SensorIndices<I...> type; };
+
+template <class Sensor, int Bits, class Indices> struct SensorTableData;
+template <class Sensor, int Bits, int... I>
+struct SensorTableData<Sensor, Bits, SensorIndices<I...> >
+{
+    static constexpr centi_t values[sizeof...(I)] =
+        { sensor_entry<Sensor, Bits>(I)... };
+};
+template <class Sensor, int Bits, int... I>
+constexpr centi_t SensorTableData<Sensor, Bits, SensorIndices<I...> >::values[];
+#endif
+
+template <class Sensor, int Bits = 7>
+class SensorTable
+{
+ public:
+  // the number of table entries
+  static const int SIZE = (1 << Bits) + 1;
+
+  static centi_t convert(uint16_t code)
+  /*-----------------------------------------------------------------------
+    Convert a reading to a temperature.
+
+    Precondition:  code is on the AnalogIn::read_u16() scale.
+    Postcondition: The interpolated temperature in centi-degrees is
+        returned.
+   ----------------------------------------------------------------------*/
+  {
+      // scale 0 - 65535 onto 0 - 65536 so the last interval ends at SIZE-1
+      uint32_t position = code + (code >> 15);
+      int index = position >> (16 - Bits);
+      int32_t fraction = position & ((1 << (16 - Bits)) - 1);
+      if(index >= SIZE - 1)
+          return values()[SIZE - 1];
+      centi_t low = values()[index];
+      centi_t high = values()[index + 1];
+      return low + (((high - low) * fraction) >> (16 - Bits));
+  }
+
+  static SENSOR_CONSTEXPR centi_t entry(int i)
+  /*-----------------------------------------------------------------------
+    Retrieve the exact (not interpolated) temperature at table index i.
+   ----------------------------------------------------------------------*/
+  {
+      return sensor_entry<Sensor, Bits>(i);
+  }
+
+ private:
+#if __cplusplus >= 201103L
+  static const centi_t * values()
+  {
+      return SensorTableData<Sensor, Bits,
+          typename SensorMakeIndices<SIZE>::type>::values;
+  }
+#else
+  // fills the table at static initialization, before main()
+  struct Builder
+  {
+      centi_t table[SIZE];
+      Builder()
+      {
+          for(int i = 0; i < SIZE; i++)
+              table[i] = sensor_entry<Sensor, Bits>(i);
+      }
+  };
+  static Builder myBuilder;
+  static const centi_t * values()
+  {
+      return myBuilder.table;
+  }
+#endif
+}; // end of class declaration
+
+#if __cplusplus < 201103L
+template <class Sensor, int Bits>
+typename SensorTable<Sensor, Bits>::Builder SensorTable<Sensor, Bits>::myBuilder;
+#endif
+
+#endif
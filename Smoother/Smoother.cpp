@@ -0,0 +1,242 @@
+/*-- Smoother.cpp----------------------------------------------------------
+             This file implements Smoother member functions.
+-------------------------------------------------------------------------*/
+
+#include <math.h>
+#include "Smoother.h"
+
+#if defined(TARGET_STM32F4)
+#include "mbed.h"
+#define SMOOTH_BARRIER() __DMB()
+#else
+#define SMOOTH_BARRIER() __sync_synchronize()
+#endif
+
+// 1.0 in Q31 (one more than the largest Q31 value)
+static const double Q31_ONE = 2147483648.0;
+static const double PI = 3.14159265358979323846;
+
+// Rounds a coefficient to Q31 after scaling it down by 2^shift
+static int32_t to_q31(double value, int shift)
+{
+    double scaled = value * Q31_ONE / (1 << shift);
+    if(scaled >= Q31_ONE - 1)
+        return 0x7FFFFFFF;
+    if(scaled <= -Q31_ONE)
+        return (int32_t)0x80000000;
+    return (int32_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+//--- Definition of Smoother constructor
+Smoother::Smoother()
+{
+    myBanks[0] = boxcar();
+    myBanks[1] = boxcar();
+    myActive = 0;
+    myPending = 0;
+    for(int i = 0; i < 4 * SMOOTH_MAX_STAGES; i++)
+        myState[i] = 0;
+    myAverage = 0;
+    myLast = 0;
+    primed = false;
+}
+
+//--- Definition of configure()
+bool Smoother::configure(const SmoothConfig & config)
+{
+    int active = myActive;
+    // the previous configuration is still waiting for process()
+    if(myPending != active)
+        return false;
+    myBanks[1 - active] = config;
+    // the bank must be complete before process() can take it
+    SMOOTH_BARRIER();
+    myPending = 1 - active;
+    return true;
+}
+
+//--- Definition of process()
+void Smoother::process(const centi_t * in, centi_t * out, int count)
+{
+    if(count > 0)
+        begin(in[0] * (1 << SMOOTH_SCALE));
+    int32_t block[SMOOTH_BLOCK];
+    for(int done = 0; done < count; done += SMOOTH_BLOCK)
+    {
+        int n = count - done < SMOOTH_BLOCK ? count - done : SMOOTH_BLOCK;
+        for(int i = 0; i < n; i++)
+            block[i] = in[done + i] * (1 << SMOOTH_SCALE);
+        filter(block, n);
+        // back to centi-degrees, rounding halves up
+        for(int i = 0; i < n; i++)
+            out[done + i] = (block[i] + (1 << (SMOOTH_SCALE - 1)))
+                            >> SMOOTH_SCALE;
+    }
+}
+
+#if !defined(TARGET_STM32F4)
+//--- Definition of sim_process()
+void Smoother::sim_process(const int32_t * in, int32_t * out, int count)
+{
+    if(count > 0)
+        begin(in[0]);
+    int32_t block[SMOOTH_BLOCK];
+    for(int done = 0; done < count; done += SMOOTH_BLOCK)
+    {
+        int n = count - done < SMOOTH_BLOCK ? count - done : SMOOTH_BLOCK;
+        for(int i = 0; i < n; i++)
+            block[i] = in[done + i];
+        filter(block, n);
+        for(int i = 0; i < n; i++)
+            out[done + i] = block[i];
+    }
+}
+#endif
+
+//--- Definition of mode()
+SmoothMode Smoother::mode() const
+{
+    return myBanks[myActive].mode;
+}
+
+//--- Definition of boxcar()
+SmoothConfig Smoother::boxcar()
+{
+    SmoothConfig config;
+    config.mode = SMOOTH_BOXCAR;
+    config.shift = 0;
+    config.stages = 0;
+    config.postShift = 0;
+    for(int i = 0; i < 5 * SMOOTH_MAX_STAGES; i++)
+        config.coeffs[i] = 0;
+    return config;
+}
+
+//--- Definition of ema()
+SmoothConfig Smoother::ema(int shift)
+{
+    SmoothConfig config = boxcar();
+    config.mode = SMOOTH_EMA;
+    config.shift = shift < 1 ? 1 : (shift > 16 ? 16 : shift);
+    return config;
+}
+
+//--- Definition of one_pole()
+SmoothConfig Smoother::one_pole(float cutoff)
+{
+    SmoothConfig config = boxcar();
+    config.mode = SMOOTH_IIR;
+    config.stages = 1;
+    // pole of y = (1 - p) x + p y1 for a -3 dB point at cutoff
+    double c = cos(2 * PI * cutoff);
+    double pole = 2 - c - sqrt((2 - c) * (2 - c) - 1);
+    config.coeffs[0] = to_q31(1 - pole, 0);
+    config.coeffs[3] = to_q31(pole, 0);
+    return config;
+}
+
+//--- Definition of lowpass()
+SmoothConfig Smoother::lowpass(float cutoff, int stages)
+{
+    SmoothConfig config = boxcar();
+    config.mode = SMOOTH_BIQUAD;
+    config.stages = stages < 1 ? 1
+                  : (stages > SMOOTH_MAX_STAGES ? SMOOTH_MAX_STAGES : stages);
+    // |a1| reaches 2: every coefficient is stored halved
+    config.postShift = 1;
+    double w0 = 2 * PI * cutoff;
+    for(int s = 0; s < config.stages; s++)
+    {
+        // the Q of section s of a Butterworth filter of order 2 * stages
+        double q = 1 / (2 * sin((2 * s + 1) * PI / (4 * config.stages)));
+        double alpha = sin(w0) / (2 * q);
+        double a0 = 1 + alpha;
+        double b = (1 - cos(w0)) / 2 / a0;
+        int32_t * k = config.coeffs + 5 * s;
+        k[0] = to_q31(b, 1);
+        k[1] = to_q31(2 * b, 1);
+        k[2] = to_q31(b, 1);
+        k[3] = to_q31(2 * cos(w0) / a0, 1);
+        k[4] = to_q31(-(1 - alpha) / a0, 1);
+    }
+    return config;
+}
+
+//--- Definition of begin(): primes the filter with the first value of a
+// block, or takes the pending configuration
+void Smoother::begin(int32_t first)
+{
+    if(!primed)
+    {
+        myLast = first;
+        primed = true;
+        take_pending();
+    }
+    else if(myPending != myActive)
+        take_pending();
+}
+
+//--- Definition of filter(): the filter in use over a block, in place
+void Smoother::filter(int32_t * block, int count)
+{
+    const SmoothConfig & config = myBanks[myActive];
+    if(config.mode == SMOOTH_EMA)
+        for(int i = 0; i < count; i++)
+            block[i] = myAverage += (block[i] - myAverage) >> config.shift;
+    else if(config.mode != SMOOTH_BOXCAR)
+        biquads(block, count);
+    myLast = block[count - 1];
+}
+
+//--- Definition of take_pending(): switches to the pending bank, starting
+// it from the last output in steady state
+void Smoother::take_pending()
+{
+    SMOOTH_BARRIER();
+    myActive = myPending;
+    myAverage = myLast;
+#if defined(TEMP_USE_CMSIS_DSP)
+    // the init clears the state: prime it afterwards
+    const SmoothConfig & config = myBanks[myActive];
+    if(config.stages > 0)
+        arm_biquad_cascade_df1_init_q31(&myInstance, config.stages,
+            (q31_t *)config.coeffs, myState, config.postShift);
+#endif
+    for(int i = 0; i < 4 * SMOOTH_MAX_STAGES; i++)
+        myState[i] = myLast;
+}
+
+//--- Definition of biquads(): the direct form I cascade, in place
+void Smoother::biquads(int32_t * block, int count)
+{
+#if defined(TEMP_USE_CMSIS_DSP)
+    arm_biquad_cascade_df1_q31(&myInstance, block, block, count);
+#else
+    const SmoothConfig & config = myBanks[myActive];
+    int shift = 31 - config.postShift;
+    for(int s = 0; s < config.stages; s++)
+    {
+        const int32_t * k = config.coeffs + 5 * s;
+        int32_t * state = myState + 4 * s;
+        int32_t x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+        for(int i = 0; i < count; i++)
+        {
+            int32_t x = block[i];
+            int64_t acc = (int64_t)k[0] * x + (int64_t)k[1] * x1
+                        + (int64_t)k[2] * x2 + (int64_t)k[3] * y1
+                        + (int64_t)k[4] * y2;
+            // keeps the low 32 bits, as the CMSIS kernel does
+            int32_t y = (int32_t)(uint32_t)(acc >> shift);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            block[i] = y;
+        }
+        state[0] = x1;
+        state[1] = x2;
+        state[2] = y1;
+        state[3] = y2;
+    }
+#endif
+}
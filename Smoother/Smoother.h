@@ -0,0 +1,170 @@
+/* Smoother.h contains the declaration of class Smoother.
+   A selectable smoothing stage for the temperature readings of a zone.
+   Readings are processed a block at a time in Q31 (centi-degrees scaled
+   by 2^SMOOTH_SCALE) by one of:
+     SMOOTH_BOXCAR: no filtering; the caller keeps its TempQueue average
+     SMOOTH_EMA:    exponential moving average, y += (x - y) / 2^shift
+     SMOOTH_IIR:    single-pole low-pass, one first-order section
+     SMOOTH_BIQUAD: cascade of up to SMOOTH_MAX_STAGES low-pass biquads
+   The IIR and biquad modes share one direct form I kernel, which is
+   arm_biquad_cascade_df1_q31() when TEMP_USE_CMSIS_DSP is defined (the
+   CMSIS-DSP library must then be linked; libmbed does not contain it),
+   and otherwise a portable kernel computing the same bits.
+   A new configuration is written into a second bank and taken by the
+   sampling path at the start of its next block, so filters can be swapped
+   at any time without stopping it; the new filter starts from the last
+   output as if it had always been in steady state.
+   Basic operations:
+     Constructor: Constructs a smoother in SMOOTH_BOXCAR mode
+     configure:   Queues a new configuration for the next block
+     process:     Filters a block of readings
+     mode:        Retrieves the mode of the configuration in use
+     boxcar, ema, one_pole, lowpass: Build configurations
+   On targets other than the STM32F4 (e.g. a Linux host) sim_process()
+   filters Q31 values and returns the Q31 outputs of the kernel, so they
+   can be checked bit for bit.
+   Class Invariant:
+      1. myActive and myPending are 0 or 1; only process() changes
+         myActive and only configure() changes myPending
+-------------------------------------------------------------------------*/
+
+#ifndef SMOOTHER
+#define SMOOTHER
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+#if defined(TEMP_USE_CMSIS_DSP)
+#ifndef ARM_MATH_CM4
+#define ARM_MATH_CM4
+#endif
+#include "arm_math.h"
+#endif
+
+// The maximum number of biquads of a SMOOTH_BIQUAD cascade
+#define SMOOTH_MAX_STAGES 3
+// Readings are filtered as centi-degrees * 2^SMOOTH_SCALE
+#define SMOOTH_SCALE 12
+// The readings process() filters in one pass of the kernel
+#define SMOOTH_BLOCK 32
+
+enum SmoothMode
+{
+    SMOOTH_BOXCAR,
+    SMOOTH_EMA,
+    SMOOTH_IIR,
+    SMOOTH_BIQUAD
+};
+
+// A filter: the EMA shift, or the Q31 coefficients {b0, b1, b2, a1, a2}
+// of every section (CMSIS order and signs: y = b.x + a1 y1 + a2 y2),
+// scaled down by 2^postShift
+struct SmoothConfig
+{
+    SmoothMode mode;
+    int shift;
+    int stages;
+    int postShift;
+    int32_t coeffs[5 * SMOOTH_MAX_STAGES];
+};
+
+class Smoother
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  Smoother();
+  /*-----------------------------------------------------------------------
+    Construct a Smoother object.
+
+    Precondition:  None.
+    Postcondition: A smoother passing readings through unchanged
+        (SMOOTH_BOXCAR) has been constructed.
+   ----------------------------------------------------------------------*/
+
+  bool configure(const SmoothConfig & config);
+  /*-----------------------------------------------------------------------
+    Queue a new filter. May be called from another thread than process().
+
+    Precondition:  config was built by one of the functions below.
+    Postcondition: Returns true if config will be used from the next call
+        to process(); returns false (nothing changed) while a previous
+        configuration has not been taken yet.
+   ----------------------------------------------------------------------*/
+
+  void process(const centi_t * in, centi_t * out, int count);
+  /*-----------------------------------------------------------------------
+    Filter a block of readings.
+
+    Precondition:  in holds count readings of one zone, oldest first;
+        out has room for count values (it may be in).
+    Postcondition: The filtered readings are stored in out and the filter
+        state is kept for the next block.
+   ----------------------------------------------------------------------*/
+
+#if !defined(TARGET_STM32F4)
+  void sim_process(const int32_t * in, int32_t * out, int count);
+  /*-----------------------------------------------------------------------
+    Filter a block of values in Q31 (centi-degrees * 2^SMOOTH_SCALE).
+
+    Precondition:  As process().
+    Postcondition: The outputs of the filter are stored in out, before
+        they are rounded back to centi-degrees; the filter state is the
+        one process() uses.
+   ----------------------------------------------------------------------*/
+#endif
+
+  SmoothMode mode() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the mode of the filter in use.
+   ----------------------------------------------------------------------*/
+
+  static SmoothConfig boxcar();
+  /*-----------------------------------------------------------------------
+    Build the pass-through configuration.
+   ----------------------------------------------------------------------*/
+
+  static SmoothConfig ema(int shift);
+  /*-----------------------------------------------------------------------
+    Build an exponential moving average of weight 1 / 2^shift (1 - 16).
+   ----------------------------------------------------------------------*/
+
+  static SmoothConfig one_pole(float cutoff);
+  /*-----------------------------------------------------------------------
+    Build a single-pole low-pass.
+
+    Precondition:  0 < cutoff < 0.5, as a fraction of the reading rate.
+    Postcondition: The configuration of a unity-gain first-order section
+        with its -3 dB point at cutoff is returned.
+   ----------------------------------------------------------------------*/
+
+  static SmoothConfig lowpass(float cutoff, int stages);
+  /*-----------------------------------------------------------------------
+    Build a Butterworth low-pass of order 2 * stages.
+
+    Precondition:  0 < cutoff < 0.5, as a fraction of the reading rate;
+        1 <= stages <= SMOOTH_MAX_STAGES.
+    Postcondition: The configuration of the cascade is returned.
+   ----------------------------------------------------------------------*/
+
+ private:
+  void begin(int32_t first);
+  void filter(int32_t * block, int count);
+  void take_pending();
+  void biquads(int32_t * block, int count);
+
+  /***** Data Members *****/
+  SmoothConfig myBanks[2];
+  volatile int myActive;
+  volatile int myPending;
+  // {x[n-1], x[n-2], y[n-1], y[n-2]} of every section
+  int32_t myState[4 * SMOOTH_MAX_STAGES];
+  int32_t myAverage;
+  int32_t myLast;
+  bool primed;
+#if defined(TEMP_USE_CMSIS_DSP)
+  arm_biquad_casd_df1_inst_q31 myInstance;
+#endif
+}; // end of class declaration
+
+#endif
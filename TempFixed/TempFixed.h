@@ -0,0 +1,101 @@
+/* TempFixed.h contains the fixed-point temperature type used from the
+   ADC reading to every output.
+   A temperature is held as a signed 32-bit count of hundredths of a degree
+   Celsius (centi-degrees). Reading or writing one is a single aligned word
+   access, so it can be shared between threads without locking, and no
+   operation below (including formatting) promotes to float or double.
+   Basic operations:
+     centi_from_u16: Converts a read_u16() scale reading to centi-degrees
+     centi_from_deg: Converts whole degrees (e.g. thresholds) to centi-deg.
+     centi_round:    Rounds centi-degrees to the nearest whole degree
+     centi_str:      Formats centi-degrees as "[-]D.dd" into a buffer
+   It also holds the timestamped records built from temperatures.
+-------------------------------------------------------------------------*/
+
+#ifndef TEMPFIXED
+#define TEMPFIXED
+
+#include <stdint.h>
+
+// A temperature in hundredths of a degree Celsius
+typedef int32_t centi_t;
+
+// A temperature together with the time it was measured at (Timebase us)
+struct TempSample
+{
+    uint64_t time_us;
+    centi_t value;
+};
+
+// A reading that moved the temperature from one band into another
+// (0: below tempMin, 1: below tempMid, 2: below tempMax, 3: above)
+struct ThresholdEvent
+{
+    uint64_t time_us;
+    centi_t value;
+    int from;
+    int to;
+};
+
+// The temperature in degrees of a full-scale (65535) sensor reading
+const int32_t TEMP_FULL_SCALE = 100;
+// The size of a buffer able to hold any string written by centi_str()
+const int CENTI_STR_SIZE = 13;
+
+/*-----------------------------------------------------------------------
+  Convert a 16-bit sensor reading to centi-degrees.
+
+  Precondition:  code is on the AnalogIn::read_u16() scale.
+  Postcondition: The rounded temperature in centi-degrees is returned.
+ ----------------------------------------------------------------------*/
+inline centi_t centi_from_u16(uint16_t code)
+{
+    return (centi_t)(((uint32_t)code * (TEMP_FULL_SCALE * 100) + 32767)
+                     / 65535);
+}
+
+/*-----------------------------------------------------------------------
+  Convert whole degrees to centi-degrees.
+ ----------------------------------------------------------------------*/
+inline centi_t centi_from_deg(int degrees)
+{
+    return (centi_t)degrees * 100;
+}
+
+/*-----------------------------------------------------------------------
+  Round centi-degrees to the nearest whole degree (halves away from 0).
+ ----------------------------------------------------------------------*/
+inline int centi_round(centi_t value)
+{
+    return value < 0 ? -(int)((-value + 50) / 100) : (int)((value + 50) / 100);
+}
+
+/*-----------------------------------------------------------------------
+  Format centi-degrees as a decimal string with two decimals.
+
+  Precondition:  out holds at least CENTI_STR_SIZE characters.
+  Postcondition: out holds e.g. "22.50" or "-0.25"; out is returned.
+ ----------------------------------------------------------------------*/
+inline char * centi_str(char * out, centi_t value)
+{
+    char digits[CENTI_STR_SIZE];
+    int n = 0;
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+    // produce the digits backwards, forcing at least "0.00"
+    do {
+        digits[n++] = '0' + magnitude % 10;
+        magnitude /= 10;
+        if(n == 2)
+            digits[n++] = '.';
+    } while(magnitude != 0 || n < 4);
+
+    char * p = out;
+    if(value < 0)
+        *p++ = '-';
+    while(n > 0)
+        *p++ = digits[--n];
+    *p = '\0';
+    return out;
+}
+
+#endif
@@ -0,0 +1,236 @@
+/* TempHistogram.h contains the declaration and the implementation of the
+   class template TempHistogram.
+   A streaming histogram of the temperature in fixed bins of Bin
+   centi-degrees (0.1 C by default) from Low up to High, used to report
+   percentiles over a period (e.g. a shift). Adding a sample increments
+   one counter: O(1), no sample is kept and nothing is allocated. Samples
+   outside the range are counted in the first or the last bin; the exact
+   minimum and maximum are kept aside. When a period is set, the histogram
+   summarizes itself and starts over once the period has elapsed, so the
+   last complete period stays available while the next one fills up.
+   RAM footprint: 4 bytes per bin, (High - Low) / Bin bins (4 KB for the
+   default 0 - 100 C in 0.1 C bins).
+   Basic operations:
+     Constructor:  Constructs an empty histogram with a period
+     add:          Counts a timestamped sample
+     reset:        Starts a new period now, discarding the current one
+     quantile:     Retrieves a percentile of the current period
+     summary:      Summarizes the current period
+     last:         Retrieves the summary of the last complete period
+     bins, bin, bin_low: Give access to the counters for exporting them
+   Class Invariant:
+      1. The sum of myBins is myCount
+      2. Low < High and (High - Low) is a multiple of Bin
+-------------------------------------------------------------------------*/
+
+#ifndef TEMPHISTOGRAM
+#define TEMPHISTOGRAM
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+// The percentiles of a period
+struct HistogramSummary
+{
+    uint64_t start_us;
+    uint64_t end_us;
+    uint32_t count;
+    centi_t min;
+    centi_t p50;
+    centi_t p95;
+    centi_t p99;
+    centi_t max;
+};
+
+template <int Low = 0, int High = 10000, int Bin = 10>
+class TempHistogram
+{
+ public:
+  // the number of bins
+  static const int BINS = (High - Low) / Bin;
+
+  /***** Function Members *****/
+  /***** Constructor *****/
+  TempHistogram(uint64_t period_us = 0);
+  /*-----------------------------------------------------------------------
+    Construct a TempHistogram object.
+
+    Precondition:  None.
+    Postcondition: An empty histogram summarizing itself every period_us
+        (never if 0) has been constructed.
+   ----------------------------------------------------------------------*/
+
+  void add(uint64_t time_us, centi_t value);
+  /*-----------------------------------------------------------------------
+    Count a sample.
+
+    Precondition:  time_us is not older than the previous sample's time.
+    Postcondition: If the period elapsed, the current one has been
+        summarized into last() and cleared; value has been counted.
+   ----------------------------------------------------------------------*/
+
+  void reset(uint64_t time_us);
+  /*-----------------------------------------------------------------------
+    Clear the histogram.
+
+    Precondition:  None.
+    Postcondition: The histogram is empty and its period starts at
+        time_us; last() is unchanged.
+   ----------------------------------------------------------------------*/
+
+  centi_t quantile(int percent) const;
+  /*-----------------------------------------------------------------------
+    Retrieve a percentile of the current period.
+
+    Precondition:  0 < percent <= 100.
+    Postcondition: The middle of the bin holding the sample of rank
+        percent % (limited to the exact min and max) is returned; zero if
+        the histogram is empty. O(BINS).
+   ----------------------------------------------------------------------*/
+
+  HistogramSummary summary(uint64_t time_us) const;
+  /*-----------------------------------------------------------------------
+    Summarize the current period up to time_us.
+   ----------------------------------------------------------------------*/
+
+  const HistogramSummary & last() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the summary of the last complete period (count 0 if none).
+   ----------------------------------------------------------------------*/
+
+  uint32_t bin(int i) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the counter of bin i (0 <= i < BINS).
+   ----------------------------------------------------------------------*/
+
+  static centi_t bin_low(int i);
+  /*-----------------------------------------------------------------------
+    Retrieve the lowest temperature counted in bin i.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  uint32_t myBins[BINS];
+  uint32_t myCount;
+  centi_t myMin;
+  centi_t myMax;
+  uint64_t myPeriod;
+  uint64_t myStart;
+  bool isStarted;
+  HistogramSummary myLast;
+}; // end of class declaration
+
+//--- Definition of TempHistogram constructor
+template <int Low, int High, int Bin>
+TempHistogram<Low, High, Bin>::TempHistogram(uint64_t period_us)
+{
+    myPeriod = period_us;
+    isStarted = false;
+    reset(0);
+    HistogramSummary none = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    myLast = none;
+}
+
+//--- Definition of add()
+template <int Low, int High, int Bin>
+void TempHistogram<Low, High, Bin>::add(uint64_t time_us, centi_t value)
+{
+    if(!isStarted)
+    {
+        myStart = time_us;
+        isStarted = true;
+    }
+    else if(myPeriod != 0 && time_us - myStart >= myPeriod)
+    {
+        // the period is over: keep its summary and start the next one
+        myLast = summary(myStart + myPeriod);
+        reset(myStart + myPeriod * ((time_us - myStart) / myPeriod));
+        isStarted = true;
+    }
+
+    int i = (value - Low) / Bin;
+    if(value < Low)
+        i = 0;
+    else if(i >= BINS)
+        i = BINS - 1;
+    myBins[i]++;
+    if(myCount == 0 || value < myMin)
+        myMin = value;
+    if(myCount == 0 || value > myMax)
+        myMax = value;
+    myCount++;
+}
+
+//--- Definition of reset()
+template <int Low, int High, int Bin>
+void TempHistogram<Low, High, Bin>::reset(uint64_t time_us)
+{
+    for(int i = 0; i < BINS; i++)
+        myBins[i] = 0;
+    myCount = 0;
+    myMin = 0;
+    myMax = 0;
+    myStart = time_us;
+}
+
+//--- Definition of quantile()
+template <int Low, int High, int Bin>
+centi_t TempHistogram<Low, High, Bin>::quantile(int percent) const
+{
+    if(myCount == 0)
+        return 0;
+    // the rank of the sample wanted, rounded up (1 is the smallest)
+    uint32_t rank = (uint32_t)(((uint64_t)myCount * percent + 99) / 100);
+    if(rank < 1)
+        rank = 1;
+    uint32_t seen = 0;
+    int i = 0;
+    for(; i < BINS - 1; i++)
+    {
+        seen += myBins[i];
+        if(seen >= rank)
+            break;
+    }
+    centi_t value = bin_low(i) + Bin / 2;
+    return value < myMin ? myMin : (value > myMax ? myMax : value);
+}
+
+//--- Definition of summary()
+template <int Low, int High, int Bin>
+HistogramSummary
+TempHistogram<Low, High, Bin>::summary(uint64_t time_us) const
+{
+    HistogramSummary result;
+    result.start_us = myStart;
+    result.end_us = time_us;
+    result.count = myCount;
+    result.min = myMin;
+    result.p50 = quantile(50);
+    result.p95 = quantile(95);
+    result.p99 = quantile(99);
+    result.max = myMax;
+    return result;
+}
+
+//--- Definition of last()
+template <int Low, int High, int Bin>
+const HistogramSummary & TempHistogram<Low, High, Bin>::last() const
+{
+    return myLast;
+}
+
+//--- Definition of bin()
+template <int Low, int High, int Bin>
+uint32_t TempHistogram<Low, High, Bin>::bin(int i) const
+{
+    return myBins[i];
+}
+
+//--- Definition of bin_low()
+template <int Low, int High, int Bin>
+centi_t TempHistogram<Low, High, Bin>::bin_low(int i)
+{
+    return Low + i * Bin;
+}
+
+#endif
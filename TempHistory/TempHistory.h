@@ -0,0 +1,228 @@
+/* TempHistory.h contains the declaration and the implementation of the
+   class template TempHistory.
+   A fixed-size temperature history at three resolutions: Seconds buckets
+   of 1 s, Minutes buckets of 1 min and Hours buckets of 1 h, each level a
+   ring whose newest bucket is the one the latest sample fell in. Every
+   sample is merged into the current bucket of every level when it is
+   added, so nothing is rolled up later and no raw sample is kept; a query
+   only visits the buckets it asks for. Periods without samples leave
+   empty buckets (count 0). Nothing is allocated.
+   RAM footprint: sizeof(HistoryBucket) (24 bytes on Cortex-M) per bucket,
+   plus about 40 bytes of state; the default 60 + 60 + 48 buckets take
+   about 4 KB and hold two days of hourly, one hour of minute and one
+   minute of second resolution.
+   Levels:
+     HISTORY_SECONDS, HISTORY_MINUTES, HISTORY_HOURS
+   Basic operations:
+     Constructor: Constructs an empty history
+     add:         Merges a timestamped sample into every level
+     buckets:     Retrieves the number of buckets of a level
+     bucket:      Retrieves a bucket of a level by age (0 is the current)
+     summary:     Merges the newest buckets of a level into one
+   Class Invariant:
+      1. myHead[l] is the position of the bucket of period myPeriod[l]
+      2. A bucket with count 0 has min, max and sum of zero
+-------------------------------------------------------------------------*/
+
+#ifndef TEMPHISTORY
+#define TEMPHISTORY
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+// The levels of a TempHistory, finest first
+enum HistoryLevel
+{
+    HISTORY_SECONDS,
+    HISTORY_MINUTES,
+    HISTORY_HOURS,
+    HISTORY_LEVELS
+};
+
+// The samples of one period of time
+struct HistoryBucket
+{
+    int64_t sum;
+    centi_t min;
+    centi_t max;
+    uint32_t count;
+
+    // the mean of the samples, zero if there is none
+    centi_t mean() const
+    {
+        if(count == 0)
+            return 0;
+        return (centi_t)(sum < 0 ? -((-sum + count / 2) / count)
+                                 : (sum + count / 2) / count);
+    }
+    // merges a sample into the bucket
+    void add(centi_t value)
+    {
+        if(count == 0 || value < min)
+            min = value;
+        if(count == 0 || value > max)
+            max = value;
+        sum += value;
+        count++;
+    }
+    // merges another bucket into this one
+    void add(const HistoryBucket & other)
+    {
+        if(other.count == 0)
+            return;
+        if(count == 0 || other.min < min)
+            min = other.min;
+        if(count == 0 || other.max > max)
+            max = other.max;
+        sum += other.sum;
+        count += other.count;
+    }
+};
+
+template <int Seconds = 60, int Minutes = 60, int Hours = 48>
+class TempHistory
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  TempHistory();
+  /*-----------------------------------------------------------------------
+    Construct a TempHistory object.
+
+    Precondition:  None.
+    Postcondition: A history with every bucket empty has been constructed.
+   ----------------------------------------------------------------------*/
+
+  void add(uint64_t time_us, centi_t value);
+  /*-----------------------------------------------------------------------
+    Add a sample to the history.
+
+    Precondition:  time_us is not older than the previous sample's time.
+    Postcondition: The buckets of the periods elapsed since the previous
+        sample have been emptied, and value has been merged into the
+        bucket of time_us of every level.
+   ----------------------------------------------------------------------*/
+
+  static int buckets(HistoryLevel level);
+  /*-----------------------------------------------------------------------
+    Retrieve the number of buckets of a level.
+   ----------------------------------------------------------------------*/
+
+  const HistoryBucket & bucket(HistoryLevel level, int age) const;
+  /*-----------------------------------------------------------------------
+    Retrieve a bucket.
+
+    Precondition:  0 <= age < buckets(level).
+    Postcondition: The bucket age periods older than the current one of
+        the level is returned.
+   ----------------------------------------------------------------------*/
+
+  HistoryBucket summary(HistoryLevel level, int count) const;
+  /*-----------------------------------------------------------------------
+    Summarize the newest buckets of a level (e.g. the peak of the last
+    hour is summary(HISTORY_MINUTES, 60).max).
+
+    Precondition:  0 < count <= buckets(level).
+    Postcondition: The merge of the current bucket and the count - 1
+        before it is returned; O(count).
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  HistoryBucket myBuckets[Seconds + Minutes + Hours];
+  uint64_t myPeriod[HISTORY_LEVELS];
+  int myHead[HISTORY_LEVELS];
+  bool isStarted;
+}; // end of class declaration
+
+// the length of the buckets of every level, in us
+static const uint64_t HISTORY_PERIOD_US[HISTORY_LEVELS] =
+    { 1000000ULL, 60000000ULL, 3600000000ULL };
+
+//--- Definition of TempHistory constructor
+template <int Seconds, int Minutes, int Hours>
+TempHistory<Seconds, Minutes, Hours>::TempHistory()
+{
+    for(int i = 0; i < Seconds + Minutes + Hours; i++)
+    {
+        HistoryBucket empty = { 0, 0, 0, 0 };
+        myBuckets[i] = empty;
+    }
+    for(int l = 0; l < HISTORY_LEVELS; l++)
+    {
+        myPeriod[l] = 0;
+        myHead[l] = 0;
+    }
+    isStarted = false;
+}
+
+//--- Definition of add()
+template <int Seconds, int Minutes, int Hours>
+void TempHistory<Seconds, Minutes, Hours>::add(uint64_t time_us,
+                                              centi_t value)
+{
+    HistoryBucket * ring = myBuckets;
+    for(int l = 0; l < HISTORY_LEVELS; l++)
+    {
+        int size = buckets((HistoryLevel)l);
+        uint64_t period = time_us / HISTORY_PERIOD_US[l];
+        if(!isStarted)
+            myPeriod[l] = period;
+        // step into the current period, emptying the ones skipped
+        uint64_t steps = period > myPeriod[l] ? period - myPeriod[l] : 0;
+        if(steps > (uint64_t)size)
+            steps = size;
+        for(; steps > 0; steps--)
+        {
+            if(++myHead[l] == size)
+                myHead[l] = 0;
+            HistoryBucket empty = { 0, 0, 0, 0 };
+            ring[myHead[l]] = empty;
+        }
+        if(period > myPeriod[l])
+            myPeriod[l] = period;
+        ring[myHead[l]].add(value);
+        ring += size;
+    }
+    isStarted = true;
+}
+
+//--- Definition of buckets()
+template <int Seconds, int Minutes, int Hours>
+int TempHistory<Seconds, Minutes, Hours>::buckets(HistoryLevel level)
+{
+    return level == HISTORY_SECONDS ? Seconds
+         : level == HISTORY_MINUTES ? Minutes : Hours;
+}
+
+//--- Definition of bucket()
+template <int Seconds, int Minutes, int Hours>
+const HistoryBucket &
+TempHistory<Seconds, Minutes, Hours>::bucket(HistoryLevel level,
+                                             int age) const
+{
+    const HistoryBucket * ring = myBuckets;
+    if(level > HISTORY_SECONDS)
+        ring += Seconds;
+    if(level > HISTORY_MINUTES)
+        ring += Minutes;
+    int size = buckets(level);
+    int position = myHead[level] - age;
+    if(position < 0)
+        position += size;
+    return ring[position];
+}
+
+//--- Definition of summary()
+template <int Seconds, int Minutes, int Hours>
+HistoryBucket
+TempHistory<Seconds, Minutes, Hours>::summary(HistoryLevel level,
+                                              int count) const
+{
+    HistoryBucket total = { 0, 0, 0, 0 };
+    for(int age = 0; age < count; age++)
+        total.add(bucket(level, age));
+    return total;
+}
+
+#endif
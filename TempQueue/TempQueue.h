@@ -1,27 +1,124 @@
-/* TempQueue.h contains the declaration of class TempQueue.
+/* TempQueue.h contains the declaration and the implementation of the
+   class template TempQueue.
+   A ring holding the last N values, with the statistics of the window
+   kept up to date on every enqueue instead of being recomputed: a running
+   sum and sum of squares (exact in 64-bit integers for integer values,
+   compensated (Kahan) in double otherwise), and two monotonic deques of
+   ring positions for the minimum and the maximum. Every operation below
+   is O(1) (enqueue amortized), whatever the window size.
    Basic operations:
      Constructor: Constructs an empty queue
      empty:       Checks if a queue is empty
-     enqueue:     Modifies a queue by adding a value at the back
-     front:       Accesses the front queue value; leaves queue unchanged
-     dequeue:     Modifies a queue by removing the value at the front
+     size:        Retrieves the number of values in the window (<= N)
+     enqueue:     Adds a value at the back, replacing the oldest when full
+     average:     Retrieves the mean of the window
+     stddev:      Retrieves the standard deviation of the window
+     minimum:     Retrieves the smallest value of the window
+     maximum:     Retrieves the largest value of the window
      display:     Displays the queue elements from front to back
    Class Invariant:
       1. The queue elements (if any) are stored in consecutive positions
-         in myArray, beginning at position myFront.
-      2. 0 <= myFront, myBack < QUEUE_CAPACITY
-      3. Queue's size < QUEUE_CAPACITY
+         (mod N) in myArray, ending before position myBack.
+      2. 0 <= myBack < N and 0 <= myCount <= N, 1 <= N <= 65535
+      3. myLow (myHigh) holds, oldest first, the positions of the values
+         smaller (larger) than every value enqueued after them
+      4. Integer statistics are exact while N * |value| < 3e9
 -------------------------------------------------------------------------*/
 
-#include <iostream>
-
 #ifndef TEMPQUEUE
 #define TEMPQUEUE
 
-//#include "AdditionProblem.h"
-const int QUEUE_CAPACITY = 10;
-typedef float QueueElement;
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <limits>
+#include "TempFixed.h"
+
+// Running sum and sum of squares of a window of values
+template <typename T, bool Integer>
+struct QueueSums
+{
+    // compensated (Kahan) sums for floating-point values
+    double sum, sumError, squares, squaresError;
+
+    QueueSums() : sum(0), sumError(0), squares(0), squaresError(0) {}
+    static void add(double & total, double & error, double value)
+    {
+        double y = value - error;
+        double t = total + y;
+        error = (t - total) - y;
+        total = t;
+    }
+    void add(T value)
+    {
+        add(sum, sumError, value);
+        add(squares, squaresError, (double)value * value);
+    }
+    void remove(T value)
+    {
+        add(sum, sumError, -(double)value);
+        add(squares, squaresError, -(double)value * value);
+    }
+    T mean(int n) const
+    {
+        return (T)(sum / n);
+    }
+    T stddev(int n) const
+    {
+        double variance = (squares - sum * sum / n) / n;
+        return (T)(variance > 0 ? sqrt(variance) : 0);
+    }
+};
+
+// Exact sums for integer values
+template <typename T>
+struct QueueSums<T, true>
+{
+    int64_t sum, squares;
+
+    QueueSums() : sum(0), squares(0) {}
+    void add(T value)
+    {
+        sum += value;
+        squares += (int64_t)value * value;
+    }
+    void remove(T value)
+    {
+        sum -= value;
+        squares -= (int64_t)value * value;
+    }
+    // the mean rounded to the nearest integer (halves away from zero)
+    T mean(int n) const
+    {
+        return (T)(sum < 0 ? -((-sum + n / 2) / n) : (sum + n / 2) / n);
+    }
+    // the rounded standard deviation, from n^2 * variance
+    T stddev(int n) const
+    {
+        int64_t scaled = (int64_t)n * squares - sum * sum;
+        if(scaled <= 0)
+            return 0;
+        // bitwise integer square root of scaled
+        uint64_t value = (uint64_t)scaled, root = 0;
+        uint64_t bit = (uint64_t)1 << 62;
+        while(bit > value)
+            bit >>= 2;
+        for(; bit != 0; bit >>= 2)
+        {
+            if(value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+                root >>= 1;
+        }
+        return (T)((root + n / 2) / n);
+    }
+};
 
+template <typename T, int N>
 class TempQueue
 {
  public:
@@ -32,44 +129,215 @@ class TempQueue
     Construct a Queue object.
 
     Precondition:  None.
-    Postcondition: An empty Queue object has been constructed; myFront 
-        and myBack are initialized to -1 and myArray is an array with
-        QUEUE_CAPACITY elements of type QueueElement.
+    Postcondition: An empty Queue object with room for N elements of type
+        T has been constructed.
    ----------------------------------------------------------------------*/
 
-  void enqueue(const QueueElement & value);
+  bool empty() const;
+  /*-----------------------------------------------------------------------
+    Check if queue is empty.
+   ----------------------------------------------------------------------*/
+
+  int size() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the number of elements in the queue (at most N).
+   ----------------------------------------------------------------------*/
+
+  void enqueue(const T & value);
   /*-----------------------------------------------------------------------
     Add a value to a queue.
 
     Precondition:  value is to be added to this queue.
-    Postcondition: value is added to back of queue provided there is space;
-        otherwise, a queue-full message is displayed and execution is
-        terminated.
+    Postcondition: value is added to back of queue; when the queue already
+        holds N elements the front (oldest) one is removed first.
    -----------------------------------------------------------------------*/
 
-  void display(char * out) ;
+  void display(char * out) const;
   /*-----------------------------------------------------------------------
     Output the values stored in the queue.
 
-    Precondition:  ostream out is open.
-    Postcondition: Queue's contents, from front to back, have been output 
-        to out.
+    Precondition:  out holds a string with room for N values.
+    Postcondition: Queue's contents, from front to back, followed by their
+        average have been appended to out.
    -----------------------------------------------------------------------*/
 
-    float average() const;
+  T average() const;
   /*-----------------------------------------------------------------------
     Retrieve the average value of queue (if any).
 
-    Precondition:  Queue is nonempty.
+    Precondition:  None.
     Postcondition: Value average of queue is returned, unless queue is
         empty; in that case, the average value is equal to zero.
    ----------------------------------------------------------------------*/
 
+  T stddev() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the (population) standard deviation of the queue.
+
+    Precondition:  None.
+    Postcondition: The standard deviation is returned; zero if the queue
+        is empty.
+   ----------------------------------------------------------------------*/
+
+  T minimum() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the smallest value of the queue.
+
+    Precondition:  None.
+    Postcondition: The smallest value is returned; zero if the queue is
+        empty.
+   ----------------------------------------------------------------------*/
+
+  T maximum() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the largest value of the queue.
+
+    Precondition:  None.
+    Postcondition: The largest value is returned; zero if the queue is
+        empty.
+   ----------------------------------------------------------------------*/
+
  private:
+  void push(uint16_t * deque, int head, int & count, bool largest);
+  void expire(uint16_t * deque, int & head, int & count);
+
   /***** Data Members *****/
-   QueueElement myArray[QUEUE_CAPACITY];
-    int count;
-    bool full;
+  T myArray[N];
+  int myBack;
+  int myCount;
+  QueueSums<T, std::numeric_limits<T>::is_integer> mySums;
+  uint16_t myLow[N];
+  int myLowHead, myLowCount;
+  uint16_t myHigh[N];
+  int myHighHead, myHighCount;
 }; // end of class declaration
 
+//--- Definition of TempQueue constructor
+template <typename T, int N>
+TempQueue<T, N>::TempQueue()
+{
+    myBack = 0;
+    myCount = 0;
+    myLowHead = myLowCount = 0;
+    myHighHead = myHighCount = 0;
+}
+
+//--- Definition of empty()
+template <typename T, int N>
+bool TempQueue<T, N>::empty() const
+{
+    return myCount == 0;
+}
+
+//--- Definition of size()
+template <typename T, int N>
+int TempQueue<T, N>::size() const
+{
+    return myCount;
+}
+
+//--- Definition of enqueue()
+template <typename T, int N>
+void TempQueue<T, N>::enqueue(const T & value)
+{
+    if(myCount == N)
+    {
+        // the front value (at myBack) leaves the window
+        mySums.remove(myArray[myBack]);
+        expire(myLow, myLowHead, myLowCount);
+        expire(myHigh, myHighHead, myHighCount);
+    }
+    else
+        myCount++;
+    myArray[myBack] = value;
+    mySums.add(value);
+    push(myLow, myLowHead, myLowCount, false);
+    push(myHigh, myHighHead, myHighCount, true);
+    if(++myBack == N)
+        myBack = 0;
+}
+
+//--- Definition of display()
+template <typename T, int N>
+void TempQueue<T, N>::display(char * out) const
+{
+    int position = myBack - myCount;
+    if(position < 0)
+        position += N;
+
+    char value[CENTI_STR_SIZE];
+    for (int i = 0; i < myCount; i++)
+    {
+        sprintf(out + strlen(out), "%d: %s ", i,
+                centi_str(value, (centi_t)myArray[position]));
+        if(++position == N)
+            position = 0;
+    }
+    sprintf(out + strlen(out), "%s\n\r", centi_str(value, average()));
+}
+
+//--- Definition of average()
+template <typename T, int N>
+T TempQueue<T, N>::average() const
+{
+    return myCount ? mySums.mean(myCount) : T();
+}
+
+//--- Definition of stddev()
+template <typename T, int N>
+T TempQueue<T, N>::stddev() const
+{
+    return myCount ? mySums.stddev(myCount) : T();
+}
+
+//--- Definition of minimum()
+template <typename T, int N>
+T TempQueue<T, N>::minimum() const
+{
+    return myCount ? myArray[myLow[myLowHead]] : T();
+}
+
+//--- Definition of maximum()
+template <typename T, int N>
+T TempQueue<T, N>::maximum() const
+{
+    return myCount ? myArray[myHigh[myHighHead]] : T();
+}
+
+//--- Definition of push(): appends the newest position (myBack) to a deque
+// after dropping the values it dominates
+template <typename T, int N>
+void TempQueue<T, N>::push(uint16_t * deque, int head, int & count,
+                           bool largest)
+{
+    const T & value = myArray[myBack];
+    while(count > 0)
+    {
+        int last = head + count - 1;
+        if(last >= N)
+            last -= N;
+        const T & kept = myArray[deque[last]];
+        if(largest ? value < kept : kept < value)
+            break;
+        count--;
+    }
+    int slot = head + count;
+    if(slot >= N)
+        slot -= N;
+    deque[slot] = (uint16_t)myBack;
+    count++;
+}
+
+//--- Definition of expire(): drops the front value (at myBack) from a deque
+template <typename T, int N>
+void TempQueue<T, N>::expire(uint16_t * deque, int & head, int & count)
+{
+    if(count > 0 && deque[head] == myBack)
+    {
+        if(++head == N)
+            head = 0;
+        count--;
+    }
+}
+
 #endif
@@ -22,13 +22,28 @@
 
 #include "TextLCD.h"
 #include "mbed.h"
+#include "rtos.h"
 
 TextLCD::TextLCD(PinName rs, PinName e, PinName d4, PinName d5,
-                 PinName d6, PinName d7, LCDType type) : _rs(rs),
+                 PinName d6, PinName d7, LCDType type, PinName rw) : _rs(rs),
         _e(e), _d(d4, d5, d6, d7),
         _type(type) {
 
-    _e  = 1;
+    _address = -1;
+    _bytes = 0;
+    _defined = 0;
+    _async = false;
+    _queued = 0;
+    _done = 0;
+    _phase = 0;
+    _running = false;
+    // the busy flag cannot be read before the function set below
+    _busy = false;
+#if TEXTLCD_USE_BUSY_FLAG
+    _rw = rw != NC ? new DigitalOut(rw, 0) : 0;
+    _d.output();
+#endif
+    _e  = 0;            // E idles low: RS and R/W settle before it rises
     _rs = 0;            // command mode
 
     wait(0.015);        // Wait 15ms to ensure powered up
@@ -42,23 +57,93 @@ TextLCD::TextLCD(PinName rs, PinName e, PinName d4, PinName d5,
     wait(0.000040f);    // most instructions take 40us
 
     writeCommand(0x28); // Function set 001 BW N F - -
+#if TEXTLCD_USE_BUSY_FLAG
+    _busy = _rw != 0;
+#endif
     writeCommand(0x0C);
     writeCommand(0x6);  // Cursor Direction and Display Shift : 0000 01 CD S (CD 0-left, 1-right S(hift) 0-no, 1-yes
+    // force a real clear: the display RAM holds anything at power-up
+    memset(_shadow, 0, sizeof(_shadow));
     cls();
 }
 
 void TextLCD::character(int column, int row, int c) {
+    bool shown = column < columns() && row < rows();
+    // the panel already shows it (0x80-0xFF may come signed or not)
+    if (shown && _shadow[row][column] == (char)c) {
+        return;
+    }
     int a = address(column, row);
-    writeCommand(a);
+    // the controller moves to the next address after each character
+    if (a != _address) {
+        writeCommand(a);
+    }
     writeData(c);
+    _address = a + 1;
+    if (shown) {
+        _shadow[row][column] = c;
+    }
 }
 
 void TextLCD::cls() {
-    writeCommand(0x01); // cls, and set cursor to 0
-    wait(0.00164f);     // This command takes 1.64 ms
+    // blanking the few characters shown is cheaper than clearing, which
+    // costs a command and 1.64ms (about 11 bytes)
+    int cost = 0;
+    for (int row = 0; row < rows(); row++) {
+        bool run = false;
+        for (int column = 0; column < columns(); column++) {
+            bool blank = _shadow[row][column] == ' ';
+            cost += blank ? 0 : (run ? 1 : 2);
+            run = !blank;
+        }
+    }
+    // (about 34 bytes when polling the busy flag)
+    if (cost <= (_busy ? 32 : 10)) {
+        for (int row = 0; row < rows(); row++) {
+            for (int column = 0; column < columns(); column++) {
+                character(column, row, ' ');
+            }
+        }
+    } else {
+        writeCommand(0x01); // cls, and set cursor to 0
+        if (!_busy && !_async) {
+            wait(0.00164f); // This command takes 1.64 ms
+        }
+        memset(_shadow, ' ', sizeof(_shadow));
+        _address = 0x80;
+    }
     locate(0, 0);
 }
 
+void TextLCD::define(int slot, const char *bitmap) {
+    slot &= 7;
+    int first = 0, last = 7;
+    if (_defined & (1 << slot)) {
+        // only the rows between the first and the last changed one
+        while (first < 8 && _glyphs[slot][first] == bitmap[first]) {
+            first++;
+        }
+        if (first == 8) {
+            return;
+        }
+        while (_glyphs[slot][last] == bitmap[last]) {
+            last--;
+        }
+    }
+    writeCommand(0x40 | (slot << 3) | first); // Set CGRAM address
+    for (int i = first; i <= last; i++) {
+        writeData(bitmap[i] & 0x1F);
+        _glyphs[slot][i] = bitmap[i];
+    }
+    _defined |= 1 << slot;
+    // the address counter now points into the CGRAM
+    _address = -1;
+}
+
+void TextLCD::cell(int column, int row, int c) {
+    character(column, row, c);
+}
+
 void TextLCD::locate(int column, int row) {
     _column = column;
     _row = row;
@@ -90,28 +175,184 @@ int TextLCD::_getc() {
 }
 
 void TextLCD::writeByte(int value) {
+    _bytes++;
+#if TEXTLCD_USE_BUSY_FLAG
+    if (_busy) {
+        // wait for the previous byte, then only the enable pulses (450ns)
+        waitReady();
+    }
+    if (_busy) {
+        _d = value >> 4;
+        _e = 1;
+        wait_us(1);
+        _e = 0;
+        wait_us(1);
+        _d = value >> 0;
+        _e = 1;
+        wait_us(1);
+        _e = 0;
+        wait_us(1);
+        return;
+    }
+#endif
+    // RS is set and the nibble is on the bus before E rises; the
+    // controller latches it when E falls
     _d = value >> 4;
+    _e = 1;
     wait(0.000040f); // most instructions take 40us
     _e = 0;
     wait(0.000040f);
-    _e = 1;
     _d = value >> 0;
+    _e = 1;
     wait(0.000040f);
     _e = 0;
     wait(0.000040f);  // most instructions take 40us
-    _e = 1;
+}
+
+void TextLCD::waitReady() {
+#if TEXTLCD_USE_BUSY_FLAG
+    // the flag is read as an instruction; the byte may be a character.
+    // E is low: RS and R/W are set before it rises (tAS, 60ns)
+    int rs = _rs;
+    _d.input();
+    _rs = 0;
+    *_rw = 1;
+    wait_us(1);
+    uint32_t start = us_ticker_read();
+    while (true) {
+        _e = 1;
+        wait_us(1);                 // DB7 is valid 360ns after E rises (tDDR)
+        bool busy = _d.read() & 0x8; // the busy flag is DB7, in the high nibble
+        _e = 0;
+        wait_us(1);
+        _e = 1;                     // the low nibble (address counter)
+        wait_us(1);
+        _e = 0;
+        wait_us(1);
+        if (!busy) {
+            break;
+        }
+        if (us_ticker_read() - start > TEXTLCD_BUSY_TIMEOUT_US) {
+            // nothing answers on R/W: use the fixed delays from now on
+            _busy = false;
+            break;
+        }
+    }
+    // E is low again: back to writing
+    *_rw = 0;
+    _d.output();
+    _rs = rs;
+#endif
+}
+
+bool TextLCD::polling() {
+    return _busy;
 }
 
 void TextLCD::writeCommand(int command) {
+    if (_async) {
+        // clear and home take 1.64ms
+        queueByte(command, 0, command < 0x04);
+        return;
+    }
     _rs = 0;
     writeByte(command);
 }
 
 void TextLCD::writeData(int data) {
+    if (_async) {
+        queueByte(data, 1, false);
+        return;
+    }
     _rs = 1;
     writeByte(data);
 }
 
+void TextLCD::queueByte(int value, int rs, bool slow) {
+    uint16_t entry = (value & 0xFF) | (rs ? 0x100 : 0) | (slow ? 0x200 : 0);
+    while (true) {
+        core_util_critical_section_enter();
+        if (_queued - _done < TEXTLCD_QUEUE_SIZE) {
+            break;
+        }
+        core_util_critical_section_exit();
+        // full: sleep while the timer makes room, so a writer of a high
+        // priority does not hold the lower ones up
+        Thread::wait(1);
+    }
+    _queue[_queued % TEXTLCD_QUEUE_SIZE] = entry;
+    _queued++;
+    _bytes++;
+    bool start = !_running;
+    if (start) {
+        _phase = 0;
+        _running = true;
+    }
+    core_util_critical_section_exit();
+    if (start) {
+        _timer.attach_us(this, &TextLCD::step, 1);
+    }
+}
+
+void TextLCD::step() {
+    // the previous byte has been executed
+    if (_phase == 4) {
+        _done++;
+        _phase = 0;
+        if (_done == _queued) {
+            _running = false;
+            return;
+        }
+    }
+    // the phases of writeByte(), one per interrupt
+    uint16_t entry = _queue[_done % TEXTLCD_QUEUE_SIZE];
+    int delay = TEXTLCD_PHASE_US;
+    switch (_phase) {
+        case 0:
+            _rs = (entry >> 8) & 1;
+            _d = entry >> 4;
+            _e = 1;
+            break;
+        case 1:
+            _e = 0;
+            break;
+        case 2:
+            _d = entry >> 0;
+            _e = 1;
+            break;
+        case 3:
+            _e = 0;
+            if (entry & 0x200) {
+                delay = 1640;
+            }
+            break;
+    }
+    _phase++;
+    _timer.attach_us(this, &TextLCD::step, delay);
+}
+
+void TextLCD::async(bool enable) {
+    if (!enable) {
+        flush();
+    }
+    _async = enable;
+}
+
+unsigned long TextLCD::fence() {
+    return _queued;
+}
+
+bool TextLCD::reached(unsigned long fence) {
+    return (long)(_done - fence) >= 0;
+}
+
+void TextLCD::flush() {
+    unsigned long last = fence();
+    while (!reached(last)) {
+        Thread::wait(1);
+    }
+}
+
 int TextLCD::address(int column, int row) {
     switch (_type) {
         case LCD20x4:
@@ -146,6 +387,10 @@ int TextLCD::columns() {
     }
 }
 
+unsigned long TextLCD::bytes() {
+    return _bytes;
+}
+
 int TextLCD::rows() {
     switch (_type) {
         case LCD20x4:
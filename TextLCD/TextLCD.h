@@ -25,10 +25,62 @@
 
 #include "mbed.h"
 
+/** Poll the busy flag of the controller when an R/W pin is given
+ *
+ * Set to 0 to always wait the worst-case delays of the datasheet
+ */
+#ifndef TEXTLCD_USE_BUSY_FLAG
+#define TEXTLCD_USE_BUSY_FLAG 1
+#endif
+
+/** The longest wait for the busy flag, in us, before falling back to the
+ * worst-case delays for good (a clear takes 1.52ms)
+ */
+#ifndef TEXTLCD_BUSY_TIMEOUT_US
+#define TEXTLCD_BUSY_TIMEOUT_US 2000
+#endif
+
+/** The number of bytes the asynchronous mode can hold (a power of 2) */
+#ifndef TEXTLCD_QUEUE_SIZE
+#define TEXTLCD_QUEUE_SIZE 64
+#endif
+
+/** The time between two phases of the enable line, in us */
+#ifndef TEXTLCD_PHASE_US
+#define TEXTLCD_PHASE_US 40
+#endif
+
 /**  A TextLCD interface for driving 4-bit HD44780-based LCDs
  *
  * Currently supports 16x2, 20x2 and 20x4 panels
  *
+ * A shadow of the display RAM is kept, so a character is only sent when
+ * it differs from what the panel already shows, and consecutive changed
+ * characters rely on the address auto-increment of the controller rather
+ * than setting the address for each one. Rewriting an unchanged screen
+ * costs no bus time at all.
+ *
+ * With the R/W line connected, the driver reads the busy flag and goes on
+ * as soon as the controller is ready (about 40us a byte) instead of
+ * waiting the worst case (160us a byte, 1.64ms a clear). If the flag
+ * stays busy for TEXTLCD_BUSY_TIMEOUT_US, the driver falls back to the
+ * fixed delays. E idles low, so RS and R/W are always set before E rises.
+ * The busy flag has only been checked against the HD44780 model of
+ * HostBench (lcd_bus.cpp): the panel of driver.h has R/W tied to ground.
+ *
+ * In the asynchronous mode the writes are put in a bounded queue and the
+ * caller returns at once (it sleeps with Thread::wait if the queue is
+ * full, and in flush()). A Timeout clocks the queued bytes out in the
+ * background, one phase of the enable line per interrupt, with the same
+ * timing as the blocking mode.
+ * fence() and reached() or flush() tell when the bytes are on the panel.
+ *
+ * The shadow and the address counter are not guarded: a single thread
+ * must write to the display (only the queue is safe against the timer).
+ *
+ * The 8 custom characters of the controller are defined with define(); a
+ * copy of each is kept so only the rows that changed are sent again.
+ *
  * @code
  * #include "mbed.h"
  * #include "TextLCD.h"
@@ -57,8 +109,9 @@ public:
      * @param e     Enable line (clock)
      * @param d4-d7 Data lines for using as a 4-bit interface
      * @param type  Sets the panel size/addressing mode (default = LCD16x2)
+     * @param rw    Read/write line, NC if it is tied to ground (default)
      */
-    TextLCD(PinName rs, PinName e, PinName d4, PinName d5, PinName d6, PinName d7, LCDType type = LCD16x2);
+    TextLCD(PinName rs, PinName e, PinName d4, PinName d5, PinName d6, PinName d7, LCDType type = LCD16x2, PinName rw = NC);
 
 #if DOXYGEN_ONLY
     /** Write a character to the LCD
@@ -85,9 +138,67 @@ public:
     /** Clear the screen and locate to 0,0 */
     void cls();
 
+    /** Write a character code to a screen position, as is
+     *
+     * Unlike putc(), no code is taken for a newline, so the custom
+     * characters 0-7 can be written. The cursor does not move.
+     *
+     * @param column  The horizontal position from the left, indexed from 0
+     * @param row     The vertical position from the top, indexed from 0
+     * @param c       The character code
+     */
+    void cell(int column, int row, int c);
+
     int rows();
     int columns();
 
+    /** Number of bytes (commands and characters) sent to the controller
+     *
+     * @returns The count since power-up; each byte takes 160us of the bus
+     */
+    unsigned long bytes();
+
+    /** Whether the busy flag is polled
+     *
+     * @returns false with fixed delays, by choice or after a timeout
+     */
+    bool polling();
+
+    /** Choose how the bytes are sent
+     *
+     * @param enable  true to queue the writes and send them from a timer
+     *                interrupt, false to send each one before returning
+     *                (the queue is flushed first)
+     */
+    void async(bool enable);
+
+    /** Mark the bytes written so far
+     *
+     * @returns A fence that reached() reports once they are on the panel
+     */
+    unsigned long fence();
+
+    /** Whether the bytes written before a fence are on the panel
+     *
+     * @param fence  A value returned by fence()
+     */
+    bool reached(unsigned long fence);
+
+    /** Wait until every byte written so far is on the panel */
+    void flush();
+
+    /** Define a custom character
+     *
+     * The panel shows the slot for the character codes slot and slot + 8
+     * (write them with cell(): putc() takes 10 for a newline). The
+     * characters already shown change at once. Only the rows that differ from the previous
+     * definition of the slot are sent.
+     *
+     * @param slot    The slot, 0-7
+     * @param bitmap  8 rows of 5 pixels (bit 4 on the left), the top first
+     */
+    void define(int slot, const char *bitmap);
+
 protected:
 
     // Stream implementation functions
@@ -99,13 +210,44 @@ protected:
     void writeByte(int value);
     void writeCommand(int command);
     void writeData(int data);
+    void waitReady();
+    void queueByte(int value, int rs, bool slow);
+    void step();
 
     DigitalOut _rs, _e;
+#if TEXTLCD_USE_BUSY_FLAG
+    BusInOut _d;
+    DigitalOut *_rw;
+#else
     BusOut _d;
+#endif
     LCDType _type;
+    // Whether the busy flag is polled before each byte
+    bool _busy;
 
     int _column;
     int _row;
+
+    // What the panel shows, and the address command matching the address
+    // counter of the controller (-1 if unknown)
+    char _shadow[4][20];
+    int _address;
+    unsigned long _bytes;
+
+    // The bitmaps of the custom characters, and which slots were defined
+    char _glyphs[8][8];
+    unsigned char _defined;
+
+    // The asynchronous mode: the queued bytes (the value, RS in bit 8 and
+    // a slow command in bit 9), the number of bytes queued and sent, the
+    // phase of the byte being sent and whether the timer is running
+    bool _async;
+    Timeout _timer;
+    uint16_t _queue[TEXTLCD_QUEUE_SIZE];
+    volatile unsigned long _queued;
+    volatile unsigned long _done;
+    int _phase;
+    volatile bool _running;
 };
 
 #endif
@@ -0,0 +1,73 @@
+/*-- ThermalPlant.cpp------------------------------------------------------
+             This file implements ThermalPlant member functions.
+-------------------------------------------------------------------------*/
+
+#include "ThermalPlant.h"
+
+// The longest integration step, s
+static const float MAX_STEP = 0.1f;
+
+//--- Definition of ThermalPlant constructor
+ThermalPlant::ThermalPlant(const PlantParams & params, float start,
+                           uint32_t seed)
+{
+    myParams = params;
+    myTemp = start;
+    mySensor = start;
+    myEnergy = 0;
+    myTime = 0;
+    mySeed = seed ? seed : 1;
+}
+
+//--- Definition of step()
+void ThermalPlant::step(float duty, float seconds)
+{
+    duty = duty < 0 ? 0 : (duty > 1 ? 1 : duty);
+    while(seconds > 0)
+    {
+        float dt = seconds < MAX_STEP ? seconds : MAX_STEP;
+        float loss = (myParams.passive + myParams.fan * duty)
+                   * (myTemp - myParams.ambient);
+        myTemp += (myParams.heat - loss) * dt / myParams.mass;
+        // the sensor follows with its own time constant
+        if(myParams.sensor_tau > 0)
+            mySensor += (myTemp - mySensor) * dt
+                      / (myParams.sensor_tau + dt);
+        else
+            mySensor = myTemp;
+        myEnergy += myParams.fan_power * duty * dt;
+        myTime += dt;
+        seconds -= dt;
+    }
+}
+
+//--- Definition of temperature()
+float ThermalPlant::temperature() const
+{
+    return myTemp;
+}
+
+//--- Definition of sensor()
+centi_t ThermalPlant::sensor()
+{
+    // xorshift32: the same seed always gives the same noise
+    mySeed ^= mySeed << 13;
+    mySeed ^= mySeed >> 17;
+    mySeed ^= mySeed << 5;
+    float noise = ((float)(mySeed >> 8) / (1 << 24) * 2 - 1)
+                * myParams.noise;
+    float reading = (mySensor + noise) * 100;
+    return (centi_t)(reading < 0 ? reading - 0.5f : reading + 0.5f);
+}
+
+//--- Definition of fan_energy()
+float ThermalPlant::fan_energy() const
+{
+    return myEnergy;
+}
+
+//--- Definition of time()
+float ThermalPlant::time() const
+{
+    return myTime;
+}
@@ -0,0 +1,110 @@
+/* ThermalPlant.h contains the declaration of class ThermalPlant.
+   A first-order thermal model of the enclosure, to run the control code
+   against without hardware. The enclosure is one thermal mass heated by
+   a constant power and losing heat to the ambient air, passively and
+   through the fan in proportion to its duty:
+       mass * dT/dt = heat - (passive + fan * duty) * (T - ambient)
+   The LM35 is modelled as a first-order lag behind T plus uniform noise
+   from a seeded generator, so a run is reproducible bit for bit. Time
+   only advances through step(): an hour of behaviour takes as long as
+   the arithmetic. No mbed header is needed.
+   Basic operations:
+     Constructor: Constructs a plant at a starting temperature
+     step:        Advances the model by some time at a fan duty
+     temperature: Retrieves the true temperature of the enclosure
+     sensor:      Retrieves an LM35 reading (lagged, noisy) in centi-deg.
+     fan_energy:  Retrieves the energy used by the fan so far
+     time:        Retrieves the simulated time
+   Class Invariant:
+      1. myParams.mass > 0 and myParams.sensor_tau >= 0
+-------------------------------------------------------------------------*/
+
+#ifndef THERMALPLANT
+#define THERMALPLANT
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+// The physical constants of an enclosure
+struct PlantParams
+{
+    // heat dissipated inside, W
+    float heat;
+    // temperature of the air around, C
+    float ambient;
+    // heat capacity, J/K
+    float mass;
+    // conductance to the ambient with the fan off, W/K
+    float passive;
+    // extra conductance with the fan at 100%, W/K
+    float fan;
+    // time constant of the sensor, s
+    float sensor_tau;
+    // amplitude of the sensor noise, C
+    float noise;
+    // electrical power of the fan at 100%, W
+    float fan_power;
+};
+
+// An enclosure settling at 50C without fan and near 31C with it at 100%
+const PlantParams DEFAULT_PLANT =
+    { 15.0f, 25.0f, 600.0f, 0.6f, 1.8f, 10.0f, 0.05f, 2.4f };
+
+class ThermalPlant
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  ThermalPlant(const PlantParams & params, float start, uint32_t seed = 1);
+  /*-----------------------------------------------------------------------
+    Construct a ThermalPlant object.
+
+    Precondition:  params describes a real enclosure (see PlantParams).
+    Postcondition: A plant whose enclosure and sensor are at start C has
+        been constructed at time 0.
+   ----------------------------------------------------------------------*/
+
+  void step(float duty, float seconds);
+  /*-----------------------------------------------------------------------
+    Advance the model.
+
+    Precondition:  0 <= duty <= 1; seconds >= 0.
+    Postcondition: The enclosure, the sensor and the fan energy have
+        evolved for seconds with the fan at duty.
+   ----------------------------------------------------------------------*/
+
+  float temperature() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the true temperature of the enclosure in C.
+   ----------------------------------------------------------------------*/
+
+  centi_t sensor();
+  /*-----------------------------------------------------------------------
+    Take a sensor reading.
+
+    Precondition:  None.
+    Postcondition: The lagged temperature plus noise is returned in
+        centi-degrees; the noise generator has advanced.
+   ----------------------------------------------------------------------*/
+
+  float fan_energy() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the energy used by the fan since time 0, in J.
+   ----------------------------------------------------------------------*/
+
+  float time() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the simulated seconds since construction.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  PlantParams myParams;
+  float myTemp;
+  float mySensor;
+  float myEnergy;
+  float myTime;
+  uint32_t mySeed;
+}; // end of class declaration
+
+#endif
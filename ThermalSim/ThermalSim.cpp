@@ -0,0 +1,149 @@
+/*-- ThermalSim.cpp--------------------------------------------------------
+             This file implements the closed-loop fan simulation.
+-------------------------------------------------------------------------*/
+
+#include "ThermalSim.h"
+#include "FanControl.h"
+#include "SensorTable.h"
+#include "MedianFilter.h"
+#include "BandClassifier.h"
+#include "TrendEstimator.h"
+#include "AdaptiveRate.h"
+
+// The path of a reading through read_temp and the averaging thread, with
+// the same objects as driver.h
+class SamplePath
+{
+ public:
+  SamplePath(const SimSettings & settings)
+      : mySettings(settings),
+        mySpikes(SPIKE_REJECT, settings.spike_limit),
+        myClassifier(settings.hysteresis, 1),
+        mySampler(settings.slowest, settings.levels, settings.start)
+  {
+      myLimits[0] = settings.minimum;
+      myLimits[1] = settings.setpoint;
+      myLimits[2] = settings.limit;
+      myTemp = settings.setpoint;
+      myBand = 1;
+      myForecast = settings.setpoint;
+  }
+
+  // takes a reading of the LM35 at time_us; returns the us to the next
+  uint64_t read(uint64_t time_us, centi_t lm35)
+  {
+      // the voltage of the LM35 on the read_u16() scale
+      int32_t code = (lm35 * 65535 + TEMP_FULL_SCALE * 50)
+                     / (TEMP_FULL_SCALE * 100);
+      code = code < 0 ? 0 : code > 65535 ? 65535 : code;
+      // read_temp: convert, drop the glitches, classify, choose the rate
+      myTemp = mySpikes.filter(
+          SensorTable<Lm35Sensor>::convert((uint16_t)code));
+      myBand = myClassifier.classify(myTemp, myLimits, 3);
+      float rate = mySampler.update(time_us, myTemp, myLimits, 3);
+      // the averaging thread: follow the trend
+      myTrend.update(time_us, myTemp);
+      myForecast = myTrend.forecast(mySettings.horizon);
+      return (uint64_t)(1000000 / rate + 0.5f);
+  }
+
+  // the thresholds (tempMin, tempMid, tempMax)
+  const centi_t * limits() const { return myLimits; }
+  // temp, temp_zone and temp_forecast of driver.h
+  centi_t temp() const { return myTemp; }
+  int band() const { return myBand; }
+  centi_t forecast() const { return myForecast; }
+
+ private:
+  const SimSettings & mySettings;
+  centi_t myLimits[3];
+  centi_t myTemp;
+  int myBand;
+  centi_t myForecast;
+  MedianFilter<centi_t, 5> mySpikes;
+  BandClassifier myClassifier;
+  TrendEstimator myTrend;
+  AdaptiveRate mySampler;
+};
+
+//--- Definition of run(): the control loop of pwm() against plant, until
+// the duration or, if tuning, the end of the experiment
+static SimResult run(ThermalPlant & plant, FanPid & pid, RelayTuner & tuner,
+                     const SimSettings & settings, bool tuning)
+{
+    SamplePath path(settings);
+    TuneRule rule = TUNE_TYREUS_LUYBEN;
+    PidGains tuned = pid.gains();
+    float setpoint = settings.setpoint / 100.0f;
+    float start = plant.time();
+    float energy = plant.fan_energy();
+    uint64_t period = settings.period_ms * 1000ULL;
+    uint64_t end = settings.duration * 1000000ULL;
+
+    SimResult result;
+    result.overshoot = 0;
+    result.settling = 0;
+    result.duty_changes = 0;
+    int32_t written = -1;
+    float duty = 0;
+    uint64_t now = 0;
+    uint64_t reading = 0;
+    uint64_t control = period;
+    while(control <= end && (!tuning || tuner.state() == TUNE_RUNNING))
+    {
+        // advance the plant to the next reading or control period
+        uint64_t next = reading < control ? reading : control;
+        if(next > now)
+            plant.step(duty, (next - now) / 1000000.0f);
+        now = next;
+        if(now == reading)
+            reading += path.read(now, plant.sensor());
+        if(now != control)
+            continue;
+        control += period;
+
+        // pwm()
+        int band = fan_band(path.band(), path.forecast(), path.limits(), 3);
+        int32_t output = fan_duty(pid, tuner, rule, tuned,
+                                  settings.setpoint, path.temp(), band, 3,
+                                  settings.period_ms);
+        if(output != written)
+        {
+            written = output;
+            duty = output / (float)PID_ONE;
+            result.duty_changes++;
+        }
+
+        float temp = plant.temperature();
+        if(temp - setpoint > result.overshoot)
+            result.overshoot = temp - setpoint;
+        // the latest time outside of the band
+        float off = temp - setpoint;
+        if(off > settings.band || off < -settings.band)
+            result.settling = plant.time() - start;
+    }
+    result.fan_energy = plant.fan_energy() - energy;
+    result.final_temp = plant.temperature();
+    return result;
+}
+
+//--- Definition of simulate_fan()
+SimResult simulate_fan(ThermalPlant & plant, const PidGains & gains,
+                       const SimSettings & settings)
+{
+    FanPid pid(gains);
+    RelayTuner tuner;
+    return run(plant, pid, tuner, settings, false);
+}
+
+//--- Definition of simulate_tune()
+TuneState simulate_tune(ThermalPlant & plant, RelayTuner & tuner,
+                        const SimSettings & settings)
+{
+    PidGains none = { 0, 0, 0 };
+    FanPid pid(none);
+    tuner.start(settings.setpoint);
+    run(plant, pid, tuner, settings, true);
+    tuner.stop();
+    return tuner.state();
+}
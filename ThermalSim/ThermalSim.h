@@ -0,0 +1,94 @@
+/* ThermalSim.h contains the closed-loop simulation of the fan control.
+   It runs the control code of the unit against a ThermalPlant under
+   virtual time and scores the run, so thresholds, gains and plants can be
+   compared reproducibly on a host: the same arguments always give the
+   same result. The readings take the path of read_temp, at the rate the
+   AdaptiveRate asks for: the LM35 voltage as a read_u16() code through
+   its SensorTable, the MedianFilter spike rejection, the BandClassifier
+   with its hysteresis and the TrendEstimator forecast. Every control
+   period the fan is then set by the decisions of pwm() (FanControl).
+   Nothing here depends on mbed.
+   Basic operations:
+     simulate_fan:  Runs the fan control loop against a plant and scores it
+     simulate_tune: Runs a relay auto-tune experiment against a plant
+-------------------------------------------------------------------------*/
+
+#ifndef THERMALSIM
+#define THERMALSIM
+
+#include "ThermalPlant.h"
+#include "FanPid.h"
+#include "RelayTuner.h"
+
+// The score of a simulated run
+struct SimResult
+{
+    // highest true temperature above the setpoint, C (0 if never above)
+    float overshoot;
+    // time after which the true temperature stayed within the band, s
+    // (the duration if it never settled)
+    float settling;
+    // energy used by the fan, J
+    float fan_energy;
+    // true temperature at the end of the run, C
+    float final_temp;
+    // number of changes of the duty written to the fan
+    unsigned duty_changes;
+};
+
+// The settings of a simulated run (driver.h holds those of the unit)
+struct SimSettings
+{
+    // the lowest threshold (tempMin), centi-degrees
+    centi_t minimum;
+    // the temperature the controller holds (tempMid), centi-degrees
+    centi_t setpoint;
+    // above this the fan runs at full speed (tempMax), centi-degrees
+    centi_t limit;
+    // period of the control loop (CONTROL_PERIOD), ms
+    uint32_t period_ms;
+    // length of the run, s
+    uint32_t duration;
+    // half-width of the settling band, C
+    float band;
+    // how far below a threshold a reading must fall to leave the band
+    // above it (BAND_HYSTERESIS), centi-degrees
+    centi_t hysteresis;
+    // how far from the median a reading is taken as a spike
+    // (spike_limit), centi-degrees
+    centi_t spike_limit;
+    // how far ahead a forecast band raises the fan (PREARM_HORIZON), s
+    int horizon;
+    // the rates of the readings (sampler): the slowest one in readings
+    // per second, the number of rates and the starting one
+    float slowest;
+    int levels;
+    int start;
+};
+
+/*-----------------------------------------------------------------------
+  Run the fan control loop against a plant.
+
+  Precondition:  settings.period_ms > 0; minimum < setpoint < limit.
+  Postcondition: plant has been run for settings.duration seconds, read
+      at the rates of the settings and driven every settings.period_ms
+      by a FanPid with gains through the decisions of pwm(), and the
+      score of the run is returned.
+ ----------------------------------------------------------------------*/
+SimResult simulate_fan(ThermalPlant & plant, const PidGains & gains,
+                       const SimSettings & settings);
+
+/*-----------------------------------------------------------------------
+  Run a relay auto-tune experiment against a plant.
+
+  Precondition:  settings.period_ms > 0; minimum < setpoint < limit.
+  Postcondition: tuner has been started around settings.setpoint and
+      plant driven through the decisions of pwm() every
+      settings.period_ms until the experiment ended, at most
+      settings.duration seconds; the state of tuner is returned
+      (TUNE_DONE if its gains can be used).
+ ----------------------------------------------------------------------*/
+TuneState simulate_tune(ThermalPlant & plant, RelayTuner & tuner,
+                        const SimSettings & settings);
+
+#endif
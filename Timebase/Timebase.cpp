@@ -0,0 +1,90 @@
+/*-- Timebase.cpp----------------------------------------------------------
+             This file implements Timebase member functions.
+-------------------------------------------------------------------------*/
+
+#include "Timebase.h"
+
+// Seconds between two keep-alive reads; must stay below the 71.6 minutes
+// it takes the 32-bit us_ticker to wrap
+static const float KEEP_ALIVE = 1800.0f;
+// The RTC is considered set once it is past 2017-01-01
+static const time_t RTC_VALID = 1483228800;
+
+//--- Definition of Timebase constructor
+Timebase::Timebase()
+{
+    myLast = 0;
+    myWraps = 0;
+    isAnchored = false;
+    myAnchorRtc = 0;
+    myAnchorUs = 0;
+}
+
+//--- Definition of start()
+void Timebase::start()
+{
+    myKeepAlive.attach(callback(this, &Timebase::refresh), KEEP_ALIVE);
+}
+
+//--- Definition of now_us()
+uint64_t Timebase::now_us()
+{
+    core_util_critical_section_enter();
+    uint32_t low = us_ticker_read();
+    // the ticker went backwards: it wrapped since the last read
+    if(low < myLast)
+        myWraps++;
+    myLast = low;
+    uint64_t now = ((uint64_t)myWraps << 32) | low;
+    core_util_critical_section_exit();
+    return now;
+}
+
+//--- Definition of anchor_rtc()
+bool Timebase::anchor_rtc()
+{
+    time_t seconds = time(NULL);
+    if(seconds < RTC_VALID)
+        return false;
+    // wait for the next second edge so the pair is exact to the tick
+    while(time(NULL) == seconds);
+    uint64_t now = now_us();
+    myAnchorRtc = (uint64_t)(seconds + 1) * 1000000;
+    myAnchorUs = now;
+    isAnchored = true;
+    return true;
+}
+
+//--- Definition of anchored()
+bool Timebase::anchored() const
+{
+    return isAnchored;
+}
+
+//--- Definition of to_rtc_us()
+uint64_t Timebase::to_rtc_us(uint64_t time_us) const
+{
+    return myAnchorRtc + (time_us - myAnchorUs);
+}
+
+//--- Definition of str()
+char * Timebase::str(char * out, uint64_t time_us)
+{
+    uint32_t micro = (uint32_t)(time_us % 1000000);
+    uint64_t seconds = time_us / 1000000;
+    // split the seconds so only 32-bit values reach printf
+    uint32_t high = (uint32_t)(seconds / 1000000000);
+    uint32_t low = (uint32_t)(seconds % 1000000000);
+    if(high)
+        sprintf(out, "%lu%09lu.%06lu", (unsigned long)high,
+                (unsigned long)low, (unsigned long)micro);
+    else
+        sprintf(out, "%lu.%06lu", (unsigned long)low, (unsigned long)micro);
+    return out;
+}
+
+//--- Definition of refresh()
+void Timebase::refresh()
+{
+    now_us();
+}
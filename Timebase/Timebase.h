@@ -0,0 +1,101 @@
+/* Timebase.h contains the declaration of class Timebase.
+   A 64-bit monotonic microsecond clock built on the 32-bit us_ticker.
+   The us_ticker wraps every 71.6 minutes; every read compares the ticker
+   with the previous one to count the wraps, and a keep-alive Ticker makes
+   sure a read happens at least every 30 minutes so no wrap is missed.
+   The clock can optionally be anchored to the RTC, which turns any of its
+   timestamps into wall-clock time.
+   Basic operations:
+     Constructor: Constructs a clock reading from the us_ticker
+     start:       Starts the keep-alive that tracks the ticker wraps
+     now_us:      Retrieves the microseconds elapsed since boot
+     anchor_rtc:  Pairs the current RTC second with now_us()
+     to_rtc_us:   Converts a timestamp to microseconds since 1970
+     str:         Formats a timestamp as seconds with 6 decimals
+   Class Invariant:
+      1. now_us() never decreases
+-------------------------------------------------------------------------*/
+
+#ifndef TIMEBASE
+#define TIMEBASE
+
+#include "mbed.h"
+
+// The size of a buffer able to hold any string written by Timebase::str()
+const int TIMEBASE_STR_SIZE = 22;
+
+class Timebase
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  Timebase();
+  /*-----------------------------------------------------------------------
+    Construct a Timebase object.
+
+    Precondition:  None.
+    Postcondition: A clock counting from the us_ticker's origin has been
+        constructed; it is not anchored to the RTC.
+   ----------------------------------------------------------------------*/
+
+  void start();
+  /*-----------------------------------------------------------------------
+    Start the keep-alive of the clock.
+
+    Precondition:  Called once, from main() or a thread.
+    Postcondition: The clock is read every 30 minutes so the wraps of the
+        32-bit ticker are always counted.
+   ----------------------------------------------------------------------*/
+
+  uint64_t now_us();
+  /*-----------------------------------------------------------------------
+    Retrieve the current time.
+
+    Precondition:  None. Safe to call from threads and interrupts.
+    Postcondition: The microseconds elapsed since boot are returned.
+   ----------------------------------------------------------------------*/
+
+  bool anchor_rtc();
+  /*-----------------------------------------------------------------------
+    Anchor the clock to the RTC.
+
+    Precondition:  The RTC has been set (set_time()).
+    Postcondition: Returns true and records the pair (RTC second, now_us)
+        if the RTC is set; otherwise returns false and keeps any previous
+        anchor.
+   ----------------------------------------------------------------------*/
+
+  bool anchored() const;
+  /*-----------------------------------------------------------------------
+    Retrieve whether anchor_rtc() succeeded at least once.
+   ----------------------------------------------------------------------*/
+
+  uint64_t to_rtc_us(uint64_t time_us) const;
+  /*-----------------------------------------------------------------------
+    Convert a timestamp of this clock to wall-clock time.
+
+    Precondition:  anchored() is true.
+    Postcondition: The microseconds since 1970-01-01 are returned.
+   ----------------------------------------------------------------------*/
+
+  static char * str(char * out, uint64_t time_us);
+  /*-----------------------------------------------------------------------
+    Format a timestamp as "seconds.micro" (e.g. "12.000250").
+
+    Precondition:  out holds at least TIMEBASE_STR_SIZE characters.
+    Postcondition: out holds the formatted timestamp and is returned.
+   ----------------------------------------------------------------------*/
+
+ private:
+  void refresh();
+
+  /***** Data Members *****/
+  Ticker myKeepAlive;
+  uint32_t myLast;
+  uint32_t myWraps;
+  bool isAnchored;
+  uint64_t myAnchorRtc;
+  uint64_t myAnchorUs;
+}; // end of class declaration
+
+#endif
@@ -0,0 +1,76 @@
+/*-- TrendEstimator.cpp----------------------------------------------------
+             This file implements TrendEstimator member functions.
+-------------------------------------------------------------------------*/
+
+#include "TrendEstimator.h"
+
+//--- Definition of TrendEstimator constructor
+TrendEstimator::TrendEstimator(float alpha, float beta)
+{
+    myAlpha = alpha;
+    myBeta = beta;
+    myLevel = 0;
+    mySlope = 0;
+    myTime = 0;
+    myReadings = 0;
+}
+
+//--- Definition of update()
+void TrendEstimator::update(uint64_t time_us, centi_t value)
+{
+    if(myReadings == 0)
+    {
+        myLevel = value;
+    }
+    else
+    {
+        float dt = (time_us - myTime) / 1000000.0f;
+        if(dt <= 0)
+            return;
+        float previous = myLevel;
+        // the level: the reading against the projection of the trend
+        myLevel = myAlpha * value + (1 - myAlpha) * (myLevel + mySlope * dt);
+        // the slope: the level's change against the smoothed slope; the
+        // first one is taken as it is
+        float change = (myLevel - previous) / dt;
+        if(myReadings == 1)
+            mySlope = change;
+        else
+            mySlope = myBeta * change + (1 - myBeta) * mySlope;
+    }
+    myTime = time_us;
+    if(myReadings < 2)
+        myReadings++;
+}
+
+//--- Definition of level()
+centi_t TrendEstimator::level() const
+{
+    return (centi_t)(myLevel < 0 ? myLevel - 0.5f : myLevel + 0.5f);
+}
+
+//--- Definition of slope()
+float TrendEstimator::slope() const
+{
+    return mySlope;
+}
+
+//--- Definition of forecast()
+centi_t TrendEstimator::forecast(float seconds) const
+{
+    float value = myLevel + mySlope * seconds;
+    return (centi_t)(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+//--- Definition of eta()
+float TrendEstimator::eta(centi_t threshold) const
+{
+    float distance = threshold - myLevel;
+    // already reached: only still reaching it while rising
+    if(distance <= 0)
+        return mySlope > 0 ? 0 : -1;
+    // moving away, or not moving at all
+    if(distance * mySlope <= 0)
+        return -1;
+    return distance / mySlope;
+}
@@ -0,0 +1,84 @@
+/* TrendEstimator.h contains the declaration of class TrendEstimator.
+   Holt's linear trend (double exponential smoothing) of the temperature,
+   for timestamped readings at any interval: a smoothed level and a
+   smoothed slope are updated in O(1) per reading, with the level first
+   projected along the slope over the time since the previous reading.
+   They give the temperature expected some time ahead and the time left
+   before a threshold is reached.
+   Basic operations:
+     Constructor: Constructs an estimator with its smoothing factors
+     update:      Feeds a timestamped reading
+     level:       Retrieves the smoothed temperature
+     slope:       Retrieves the smoothed slope in centi-degrees per second
+     forecast:    Retrieves the temperature expected some seconds ahead
+     eta:         Retrieves the seconds left before reaching a threshold
+   Class Invariant:
+      1. 0 < myAlpha <= 1 and 0 < myBeta <= 1
+-------------------------------------------------------------------------*/
+
+#ifndef TRENDESTIMATOR
+#define TRENDESTIMATOR
+
+#include <stdint.h>
+#include "TempFixed.h"
+
+class TrendEstimator
+{
+ public:
+  /***** Function Members *****/
+  /***** Constructor *****/
+  TrendEstimator(float alpha = 0.3f, float beta = 0.1f);
+  /*-----------------------------------------------------------------------
+    Construct a TrendEstimator object.
+
+    Precondition:  0 < alpha, beta <= 1 (weights of the newest reading in
+        the level and of the newest slope in the trend).
+    Postcondition: An estimator without readings (flat) has been
+        constructed.
+   ----------------------------------------------------------------------*/
+
+  void update(uint64_t time_us, centi_t value);
+  /*-----------------------------------------------------------------------
+    Feed a reading.
+
+    Precondition:  time_us is later than the previous reading's time.
+    Postcondition: The level and the slope include value.
+   ----------------------------------------------------------------------*/
+
+  centi_t level() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the smoothed temperature at the latest reading.
+   ----------------------------------------------------------------------*/
+
+  float slope() const;
+  /*-----------------------------------------------------------------------
+    Retrieve the smoothed slope in centi-degrees per second.
+   ----------------------------------------------------------------------*/
+
+  centi_t forecast(float seconds) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the temperature expected seconds after the latest reading.
+   ----------------------------------------------------------------------*/
+
+  float eta(centi_t threshold) const;
+  /*-----------------------------------------------------------------------
+    Retrieve the time left before the trend reaches a threshold.
+
+    Precondition:  None.
+    Postcondition: The seconds from the latest reading until a rising
+        level() + slope() * t == threshold are returned; 0 if the level
+        is at or above it and rising, and -1 if the level is at or above
+        it and not rising, or below it and not rising.
+   ----------------------------------------------------------------------*/
+
+ private:
+  /***** Data Members *****/
+  float myAlpha;
+  float myBeta;
+  float myLevel;
+  float mySlope;
+  uint64_t myTime;
+  int myReadings;
+}; // end of class declaration
+
+#endif
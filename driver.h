@@ -1,13 +1,62 @@
 #include "mbed.h"
 #include "rtos.h"
 #include "TextLCD.h"
+#include "LcdCompositor.h"
+#include "LcdWidgets.h"
+#include "TempFixed.h"
+#include "SensorTable.h"
 #include "TempQueue.h"
+#include "MedianFilter.h"
+#include "TempHistory.h"
+#include "SampleChannel.h"
+#include "Smoother.h"
+#include "TempHistogram.h"
+#include "TrendEstimator.h"
+#include "EventHub.h"
+#include "BandClassifier.h"
+#include "FanPid.h"
+#include "RelayTuner.h"
+#include "FanControl.h"
+#include "FanTach.h"
+#include "AdcDma.h"
+#include "AdaptiveRate.h"
+#include "Timebase.h"
 
 // The main output of the program. Currently connected to an LED but
 // can be potentially connected to a fan, motor, etc.
 PwmOut mypwm(D5);
-// The LM35 sensor for temperature 
-AnalogIn temp_sensor(A0);
+// The analog pins of the LM35 sensors, one per monitored zone (up to 8).
+// Zone 0 is the reference zone that drives the outputs. Add a pin here
+// (e.g. A1, A2, A3) to monitor another zone
+const PinName zone_pins[] = { A0 };
+// The number of monitored zones
+const int zones = sizeof(zone_pins) / sizeof(zone_pins[0]);
+// The transfer function of the sensor of each zone, in the order of
+// zone_pins. Each converts a reading with a table built before main() runs
+// e.g. &SensorTable< NtcSensor<10000, 3950, 10000> >::convert for a 10k NTC
+// or &SensorTable< Pt100Sensor<80000, 180000> >::convert for a PT100
+centi_t (* const zone_sensor[])(uint16_t) = {
+    &SensorTable<Lm35Sensor>::convert
+};
+// The LM35 sensors for temperature. A timer triggers the ADC which scans 
+// all the zones in one pass and the DMA stores the conversions: each 
+// reading is the mean of 64 conversions and a reading of every zone is 
+// produced every 3 seconds
+AdcDma temp_sensor(zone_pins, zones, 64, 1 / 3.0f);
+// ADC_PWM_SYNC makes the timer of mypwm trigger the conversions, in the
+// middle of the off-period of the fan, so its switching no longer shows
+// in the readings. The rate is then a whole number of PWM periods
+const bool ADC_PWM_SYNC = true;
+// PWM_PERIOD_US holds the period of mypwm; the fastest sampling rate needs
+// 2 * 2.67 * 64 PWM periods per second
+const int PWM_PERIOD_US = 1000;
+// The sampling rate policy of temp_sensor: from a reading every 12 seconds
+// when flat and far from the thresholds, up to 2.67 readings per second
+// close to them. It starts at a reading every 3 seconds (level 2)
+AdaptiveRate sampler(1 / 12.0f, 6, 2);
+// The tachometer output of the fan (2 pulses per turn). A fan slower than
+// 300 rpm for 3 seconds while driven at 30% or more is stalled
+FanTach fan_tach(D7, 2, 300, 19661, 3000);
 // Connected to a red LED
 DigitalOut red(D4);
 // Connected to a yellow LED
@@ -60,7 +109,26 @@ Thread remote_session_thread;
 Thread keyboard_readable_thread;
 // The text lcd is a 16x2 characters connected to the GPIO
 // It will help us display values as well as to operate the keypad
+// Its R/W line is tied to ground: the TextLCD waits the worst-case delays
+// and its busy-flag path is not used on this board
 TextLCD lcd ( PB_8, PB_9, PA_5,   PA_6,   PA_7,   PB_6);
+// The threads write to layers of the LCD; the render thread alone writes
+// the layer on top to the LCD
+LcdCompositor screen(lcd);
+// The temperatures and the auto-tune progress
+LcdLayer status(screen, LAYER_STATUS, true);
+// The password and the initialization prompts, over the status
+LcdLayer modal(screen, LAYER_MODAL);
+// The emergency countdown, over everything
+LcdLayer alert(screen, LAYER_EMERGENCY);
+// This thread renders the layer on top of the LCD
+Thread lcd_thread;
+// Show the trend of the last minutes and the duty of the fan as graphs on
+// the second line of the LCD, instead of when tempMax will be reached
+const bool LCD_GRAPHS = true;
+// The minutes of the trend (a cell each) and the cells of the duty
+const int SPARK_CELLS = 10;
+const int DUTY_CELLS = 5;
 // This button starts the emergency thread when pressed
 InterruptIn emerg_button(USER_BUTTON);
 // This serial port allows us to send data to the pc terminal
@@ -73,13 +141,22 @@ const int thread_wait_short = 300;
 const int thread_wait_med = 1500;
 // This is the default waiting time for long durations
 const int thread_wait_long = 3000;
+// The hub wakes the output threads when a reading, a band change or a new
+// average is published, with this signal
+const int32_t HUB_SIGNAL = 0x2;
+EventHub hub;
+// The subscriptions of the output threads to hub (see main())
+int led_subscriber = -1;
+int uart_subscriber = -1;
+int display_subscriber = -1;
 // This is the default size of a string
 const int buffer = 1024;
-// Temp holds the value of the temperature. Starting value is 22
-float temp = 22;
-// Temp holds the value of the average of the temperature values.
-// Starting value is 20
-float temp_avg = 20;
+// Temp holds the value of the temperature in centi-degrees (see TempFixed.h)
+// It is written with a single word store. Starting value is 22C
+volatile centi_t temp = 2200;
+// Temp holds the value of the average of the temperature values in 
+// centi-degrees. Starting value is 20C
+volatile centi_t temp_avg = 2000;
 // TempMin holds the value of the minimum temperature. Default value is 10
 int tempMin = 10;
 // TempMid holds the value of the medium temperature. Default value is 50
@@ -88,11 +165,119 @@ int tempMid = 50;
 int tempMax = 100;
 // Pass holds the value of the numeric password. Default value is 1313
 int pass = 1313;
-// TempQueue holds the values for the previous <= 10 temperature values
-// These values will be used when calculating the average
-TempQueue averages;
+// Zone_temp holds the latest temperature of every zone in centi-degrees
+// zone_temp[0] is also published as temp
+volatile centi_t zone_temp[zones];
+// Zone_avg holds the average temperature of every zone in centi-degrees
+// zone_avg[0] is also published as temp_avg
+volatile centi_t zone_avg[zones];
+// Spike_limit holds how far (centi-degrees) a reading may be from the 
+// median of the last readings of its zone before it is taken as a glitch
+const centi_t spike_limit = 300;
+// Spike_filters reject the glitches of each zone before they reach temp,
+// the outputs and the averages: the median of the last 5 readings replaces
+// any reading further than spike_limit from it
+MedianFilter<centi_t, 5> spike_filters[zones];
+// Zone_samples carry every timestamped reading of each zone from read_temp
+// to the averaging thread, which drains them all (lock-free, one producer
+// and one consumer); a full channel drops and counts the reading
+SampleChannel<TempSample, 32> zone_samples[zones];
+// AVERAGE_WINDOW holds how many of the latest readings the averages cover;
+// readings synchronized with the PWM need less averaging
+const int AVERAGE_WINDOW = ADC_PWM_SYNC ? 5 : 10;
+// TempQueue holds the values for the previous <= AVERAGE_WINDOW temperature
+// values of each zone. These values will be used when calculating the
+// averages, and the spread, minimum and maximum of the window
+TempQueue<centi_t, AVERAGE_WINDOW> averages[zones];
+// Smoothers filter the readings of each zone when a smoothing mode other
+// than the TempQueue average is selected from the remote session
+Smoother smoothers[zones];
+// History holds the minimum, maximum and mean of zone 0 for every second
+// of the last minute, minute of the last hour and hour of the last 2 days
+// (about 4 KB of RAM; the bucket counts are its template parameters)
+TempHistory<60, 60, 48> history;
+// PERCENTILE_PERIOD holds the period (a shift, us) the percentiles cover
+const uint64_t PERCENTILE_PERIOD = 8ULL * 3600 * 1000000;
+// Percentiles counts the readings of zone 0 in 0.1C bins (about 4 KB) to
+// report their P50/P95/P99 and maximum over every PERCENTILE_PERIOD
+TempHistogram<0, 10000, 10> percentiles(PERCENTILE_PERIOD);
+// Protects history and percentiles, written by the averaging thread and
+// read by the UART and keyboard threads
+Mutex history_mutex;
+// BAND_HYSTERESIS holds how far (centi-degrees) below a threshold the
+// temperature must fall to leave the band above it
+centi_t BAND_HYSTERESIS = 50;
+// Classifier puts every reading of zone 0 in a band of the thresholds
+BandClassifier classifier(BAND_HYSTERESIS, 1);
+// Temp_zone holds the band of the latest reading (0: cold, 1: stable,
+// 2: high, 3: heated), published to the outputs
+volatile int temp_zone = 1;
+// Outputs_off tells, for the emergency and the remote session, that the
+// thread turned the outputs off and has not given them back yet (each
+// entry is written by its thread only); the pwm and led threads keep the
+// outputs off meanwhile
+enum OutputsOwner { OFF_EMERGENCY, OFF_REMOTE, OFF_OWNERS };
+volatile bool outputs_off[OFF_OWNERS] = { false, false };
+// Outputs_epoch is incremented when the outputs were turned off by another
+// thread (emergency, remote session), for their threads to restore them
+volatile unsigned outputs_epoch = 0;
+// The state of the leds in every band
+const int band_green[4] = { 0, 1, 1, 0 };
+const int band_yellow[4] = { 1, 1, 0, 0 };
+const int band_red[4] = { 0, 0, 1, 1 };
+const char * const band_names[4] = { "Cold", "Stable", "High", "Heated" };
+// CONTROL_PERIOD holds the period (ms) of the fan control loop
+int CONTROL_PERIOD = 250;
+// Fan_pid holds the fan duty needed to keep zone 0 at tempMid: 10% per
+// degree, 0.5% per degree-second and 20% per degree per second
+const PidGains default_gains = { 6554, 328, 13107 };
+FanPid fan_pid(default_gains);
+// Tuner runs the relay auto-tune of the remote session on the fan, around
+// tempMid; the pwm thread applies its gains to fan_pid once it succeeded
+RelayTuner tuner;
+// Tune_rule holds the rule the gains of the auto-tune are computed with
+TuneRule tune_rule = TUNE_TYREUS_LUYBEN;
+// Tuned_gains holds the gains of the latest successful auto-tune
+PidGains tuned_gains = default_gains;
+// Protects fan_pid, tuner, tuned_gains and CONTROL_PERIOD, changed by the
+// remote session
+Mutex pid_mutex;
+// Trend follows the level and the slope of zone 0 to predict crossings
+TrendEstimator trend;
+// PREARM_HORIZON holds how far ahead (secs) a predicted band raises the fan
+int PREARM_HORIZON = 30;
+// Temp_forecast holds the temperature of zone 0 expected PREARM_HORIZON
+// seconds after the latest reading
+volatile centi_t temp_forecast = 2200;
+// Eta_max holds the seconds before zone 0 reaches tempMax at the current
+// trend, -1 if it is not heading there
+volatile int32_t eta_max = -1;
 // TIMEOUT holds the value of the emergency timeout duration. Default = 3 secs
 int TIMEOUT = 3;
+// The 64-bit microsecond clock that stamps samples and events
+Timebase timebase;
+// Block_time holds the time the DMA completed the latest block of readings
+volatile uint64_t block_time = 0;
+// Temp_sample holds the latest reading of zone 0 with the time it was taken
+TempSample temp_sample = { 0, 2200 };
+// Last_crossing holds the latest threshold crossing of zone 0
+ThresholdEvent last_crossing = { 0, 2200, 1, 1 };
+// Protects temp_sample and last_crossing, which are too wide to be
+// written in a single store
+Mutex sample_mutex;
+// Emergency_time holds the time the latest emergency was triggered
+volatile uint64_t emergency_time = 0;
+// Fan_stalled is set when the latest emergency was raised by a stalled fan
+// rather than by the user
+volatile bool fan_stalled = false;
+// Fan_stalls holds how many times the fan stalled
+unsigned fan_stalls = 0;
+// Sample_jitter holds the largest deviation (us) of the interval between
+// two readings from the sampling period
+uint32_t sample_jitter = 0;
+// Reaction_latency holds the time (us) between the latest threshold 
+// crossing and the fan output reacting to it
+uint32_t reaction_latency = 0;
 
 /** char keypad(void);
 * Objective: Keypad returns the ascii code of the character pressed 
@@ -208,24 +393,64 @@ void changeTempPass(void);
 */
 void changeInit(void);
 
+/** char *stamp(char *out, uint64_t time_us);
+* Objective: Formats a timestamp of timebase for display, as wall-clock
+*            time if the timebase is anchored to the RTC
+* Pre-conditions: out holds at least TIMEBASE_STR_SIZE characters
+* Post-conditions: Returns out
+*/
+char *stamp(char *out, uint64_t time_us);
+
+/** void adc_block_ready(void);
+* Objective: Wakes the temperature reading thread once the DMA has filled
+*            a block of conversions
+* Pre-conditions: Called from the DMA interrupt of temp_sensor
+* Post-conditions: Sets the signal read_temp thread is waiting for
+*/
+void adc_block_ready(void);
+
+/** void print_percentiles(void);
+* Objective: Exports the percentiles of zone 0 on the UART as one block:
+*            the summaries of the current and of the last complete period,
+*            then the non-empty bins of the current one as index:count,
+*            a line of 10 read under history_mutex at a time (cut short if
+*            the period ends during the export)
+* Pre-conditions: None
+* Post-conditions: The block has been written to pc, ending with "END"
+*/
+void print_percentiles(void);
+
+/** int read_number(void);
+* Objective: Reads a positive number typed on the UART
+* Pre-conditions: pc is serially connected to the unit
+* Post-conditions: Returns the digits typed before enter or space
+*/
+int read_number(void);
+
 /** void read_temp(void);
-* Objective: Reads the voltage at the LM35 temperature sensor
-* Pre-conditions: Sensor is working and connected
-* Post-conditions: Returns the reading in temp float variable
+* Objective: Reads the voltage at the LM35 temperature sensor of each zone
+* Pre-conditions: Sensors are working and connected
+* Post-conditions: Returns the readings in zone_temp, and the reading of
+*                  zone 0 in temp, as centi-degrees, and its band in
+*                  temp_zone. The sampling rate follows sampler
 */
 void read_temp(void);
 
 /** void pwm(void);
-* Objective: Changes the pulse-width of the PWM pin
+* Objective: Controls the pulse-width of the PWM pin every CONTROL_PERIOD
 * Pre-conditions: myPwm is connected
-* Post-conditions: myPwm is changed based on temp, temp_min/mid/max
+* Post-conditions: myPwm follows fan_pid, or the relay of tuner while an
+*                  auto-tune runs, at full speed when temp_zone (or the
+*                  band of temp_forecast) is above tempMax; it is only
+*                  written when the duty changes. The speed of the fan is
+*                  measured every period and a stall raises an emergency
 */
 void pwm(void);
 
 /** void led(void);
 * Objective: Toggles the status of the leds based on temperature
 * Pre-conditions: leds red, yellow, green are connected
-* Post-conditions: leds red, yellow, green change based on temp,temp_min/mid/max
+* Post-conditions: leds red, yellow, green change when temp_zone changes
 */
 void led(void);
 
@@ -245,12 +470,19 @@ void display_temp(void);
 
 
 /** void temperature_average(void);
-* Objective: Calculates the average temperature
+* Objective: Calculates the average temperature of every zone
 * Pre-conditions: none.
-* Post-conditions: temp_average is changed
+* Post-conditions: zone_avg and temp_avg are changed
 */
 void temperature_average(void);
 
+/** void lcd_render(void);
+* Objective: Renders the layer on top of the LCD whenever it changes
+* Pre-conditions: No other thread writes to the LCD
+* Post-conditions: none (never returns)
+*/
+void lcd_render(void);
+
 /** void flash_emergency_message(bool &exclamation);
 * Objective: Flashes a line that reads emergency on line1 of the LCD
 * Pre-conditions: An LCD is connected to the GPIO
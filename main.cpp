@@ -91,13 +91,13 @@ int keypad_disp(int column, int row, int size)
     // The value that the user is trying to enter iteratively until he submits
     char value[size + 1];
     // Locate the lcd to the desired spot
-    lcd.locate(column, row);
+    modal.locate(column, row);
     // Enter blanks '_' on the screen equal to the maximum size of entry
     for(int i = column; i < column + size; i++) {
-        lcd.putc('_');
+        modal.putc('_');
     }
     // Relocate the LCD back at the beginning of the entry blanks
-    lcd.locate(column, row);
+    modal.locate(column, row);
     // How many values are entered shifting the cursor from the origin
     int shift = 0;
     // Keep looping until a condition breaks the loop
@@ -113,9 +113,9 @@ int keypad_disp(int column, int row, int size)
             // go back if he is not on the first character (nothing entered yet)
             shift = (shift <= 0 ? 0 : shift - 1);
             // relocate the lcd whether on new position or on the same on
-            lcd.locate(column + shift, row);
+            modal.locate(column + shift, row);
             // declare this position as available by putting blank '_'
-            lcd.putc('_');
+            modal.putc('_');
 
             // if the user wants to clear the line:
         } else if( c == 'C') {
@@ -123,20 +123,20 @@ int keypad_disp(int column, int row, int size)
             // beginning
             shift = 0;
             // relocate the screen accordingly
-            lcd.locate(column + shift, row);
+            modal.locate(column + shift, row);
             // Enter blanks '_' on the screen equal to the maximum size of entry
             for(int i = column; i < column + size; i++) {
-                lcd.putc('_');
+                modal.putc('_');
             }
             // Relocate the LCD back at the beginning of the entry blanks
-            lcd.locate(column, row);
+            modal.locate(column, row);
 
             // if the user enters an actual number, make sure it fits
         } else if(shift < size ) {
             // relocate the cursor according to the shift value
-            lcd.locate(column + shift, row);
+            modal.locate(column + shift, row);
             // insert the character on screen
-            lcd.putc(c);
+            modal.putc(c);
             // add the inserted value to the list of collected valuess
             value[shift] = c;
             // shift by a character position for the next one, or to declare
@@ -255,21 +255,21 @@ char keypad(void)
 void changeTempMax(void)
 {
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the current maximum temperature
-    lcd.printf("TempMax = %3dC  ", tempMax);
+    modal.printf("TempMax = %3dC  ", tempMax);
     // Display a message on the UART declaring the current state
     pc.printf("Prompting the user to change temperature maximum.\n\r");
     // Read the temperature from the user
     tempMax = keypad_disp(6, 1, 3);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display a suitable message
-    lcd.printf("      DONE!      ");
+    modal.printf("      DONE!      ");
     // wait for the user to release the key
     while(keypad_pressed());
     // Display a message on the UART declaring the current state
@@ -283,21 +283,21 @@ void changeTempMax(void)
 void changeTempMid(void)
 {
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the current medium temperature
-    lcd.printf("TempMid = %3dC  ", tempMid);
+    modal.printf("TempMid = %3dC  ", tempMid);
     // Display a message on the UART declaring the current state
     pc.printf("Prompting the user to change temperature average.\n\r");
     // Read the temperature from the user
     tempMid = keypad_disp(6, 1, 3);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display a suitable message
-    lcd.printf("      DONE!      ");
+    modal.printf("      DONE!      ");
     // wait for the user to release the key
     while(keypad_pressed());
     // Display a message on the UART declaring the current state
@@ -311,21 +311,21 @@ void changeTempMid(void)
 void changeTempMin(void)
 {
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the current minimum temperature
-    lcd.printf("TempMin = %3dC  ", tempMin);
+    modal.printf("TempMin = %3dC  ", tempMin);
     // Display a message on the UART declaring the current state
     pc.printf("Prompting the user to change temperature minimum.\n\r");
     // Read the temperature from the user
     tempMin = keypad_disp(6, 1, 3);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display a suitable message
-    lcd.printf("      DONE!      ");
+    modal.printf("      DONE!      ");
     // wait for the user to release the key
     while(keypad_pressed());
     // Display a message on the UART declaring the current state
@@ -339,22 +339,22 @@ void changeTempMin(void)
 void changeTempEmergTimer(void)
 {
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the current timeout value
-    lcd.printf("TIMEOUT = %3d    ", TIMEOUT);
+    modal.printf("TIMEOUT = %3d    ", TIMEOUT);
     // Display a message on the UART declaring the current state
     pc.printf("Prompting the user to change the"
         " emergency timer value from: %d.\n\r", TIMEOUT);
     // Read the timeout value from the user
     TIMEOUT = keypad_disp(6, 1, 3);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display a suitable message
-    lcd.printf("      DONE!      ");
+    modal.printf("      DONE!      ");
     // wait for the user to release the key
     while(keypad_pressed());
     // Display a message on the UART declaring the current state
@@ -370,11 +370,11 @@ bool sureD(void)
     // wait for the user to release the key
     while(keypad_pressed());
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the confirmation
-    lcd.printf("Sure? A:Yes B:No");
+    modal.printf("Sure? A:Yes B:No");
     // Display a message on the UART declaring the current state
     pc.printf("Making sure the user wants to keep the default\n\r");
     // variable to save the user's entry
@@ -391,10 +391,10 @@ bool sureD(void)
             // if the index is out of bound, go back to zero
             if(i == 3) i = 0;
             // Relocate the screen to the second line
-            lcd.locate(0,1);
+            modal.locate(0,1);
             // Print the messages that were prepared by the previous function
             // without recreating them
-            lcd.printf("%s", msg[i++]);
+            modal.printf("%s", msg[i++]);
             // reset the timer to wait for another 2 seconds before updating
             t2.reset();
         }
@@ -403,17 +403,17 @@ bool sureD(void)
         // keep repeating until the user enters an A or B
     } while(choice != 'A' && choice != 'B');
     // clear the LCD screen from the previous values
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // If the user is sure
     if(choice == 'A')
         // display a suitable message
-        lcd.printf("Using default   ");
+        modal.printf("Using default   ");
     // If the user is not sure
     if(choice == 'B')
         // display a suitable message
-        lcd.printf("Changing Default");
+        modal.printf("Changing Default");
     // make sure previous command was fully executed
     wait_ms(20);
     // wait for the user to release the key
@@ -423,7 +423,7 @@ bool sureD(void)
     // make sure previous command was fully executed
     wait_ms(20);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // wait some time after the user releases the key
     //  before the message disappears
     wait(0.1);
@@ -435,21 +435,21 @@ bool sureD(void)
 void changeTempPass(void)
 {
     // Clear previous values from the screen
-    lcd.cls();
+    modal.cls();
     // Relocate the screen to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // Display a message with the current password
-    lcd.printf("PASS = %8d", pass);
+    modal.printf("PASS = %8d", pass);
     // Display a message on the UART declaring the current state
     pc.printf("Prompting the user to change the password from: %d.\n\r", pass);
     // Read the password value from the user
     pass = keypad_disp(4, 1, 8);
     // Clear the screen after input
-    lcd.cls();
+    modal.cls();
     // Relocate the screen back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display a suitable message
-    lcd.printf("      DONE!      ");
+    modal.printf("      DONE!      ");
     // wait for the user to release the key
     while(keypad_pressed());
     // Display a message on the UART declaring the current state
@@ -488,10 +488,12 @@ void init_mode(void)
     // allocate a place in the memory for the messages to be displayed
     for(int i = 0; i < 3; i++)
         msg[i] = new char[buffer];
+    // cover the status with the prompts
+    modal.show();
     // relocate the lcd to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // prompt the user to choose either default or custom values
-    lcd.printf("Custom/Default?");
+    modal.printf("Custom/Default?");
     // timer is created that will allow us to change the displayed message
     Timer t;
     // start the counter before looping
@@ -517,9 +519,9 @@ void init_mode(void)
             sprintf( msg[2], "TempHigh = %3dC ",tempMax);
         }
         // relocate the lcd to the origin
-        lcd.locate(0,1);
+        modal.locate(0,1);
         // print the message that we just updated on the screen
-        lcd.printf("%s", msg[count]);
+        modal.printf("%s", msg[count]);
         // return the value of option to 0 
         option = 0;
         // do not test user's input unless a key is pressed
@@ -559,6 +561,8 @@ void init_mode(void)
     // if the option choosen is C, then go ahead and change the initial values
     if(option == 'C')
         changeInit();
+    // the prompts are done: show the status again
+    modal.hide();
 }
 
 // Defiinition of password function that halts the system unless the password
@@ -569,12 +573,14 @@ void password(void)
     int attempts = 3;
     // the state of our lock
     bool correct = false;
+    // cover the status with the prompts
+    modal.show();
     // delete previous values on the screen
-    lcd.cls();
+    modal.cls();
     // relocate the lcd back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // display the current state of the system: Locked
-    lcd.printf("     LOCKED     ");
+    modal.printf("     LOCKED     ");
 
     // keep trying as long as there is an attempt left
     while(attempts > 0) {
@@ -591,24 +597,24 @@ void password(void)
             // Display a message on the UART declaring the current state
             pc.printf("Entered password is wrong!\n\r");
             // relocate the lcd back to the origin
-            lcd.locate(0,0);
+            modal.locate(0,0);
             // decrement the number of attempts left
             attempts--;
             // display a message on the lcd stating that the password is 
             // incorrect along with the number of remaining attempts
-            lcd.printf("Wrong:%d attempts", attempts);
+            modal.printf("Wrong:%d attempts", attempts);
             
         }
 
     }
     // clear the lcd screen to display the current state of the system
-    lcd.cls();
+    modal.cls();
     // relocate the lcd back to the origin
-    lcd.locate(0,0);
+    modal.locate(0,0);
     // if the password is incorrect
     if(!correct) {
         // display a message stating that the system is locked
-        lcd.printf("     LOCKED     ");
+        modal.printf("     LOCKED     ");
         // Display a message on the UART declaring the current state
         pc.printf("The system has been locked "
             "due to many failed attempts.\n\r");
@@ -617,7 +623,7 @@ void password(void)
     } else
         // if the password is correct, display a message stating that the 
         // system is unlocked
-        lcd.printf("    UNLOCKED    ");
+        modal.printf("    UNLOCKED    ");
         // Display a message on the UART declaring the current state
         pc.printf("The system has been unlocked.\n\r");
 
@@ -625,16 +631,121 @@ void password(void)
     wait(1);
 }
 
+// definition of the timestamp formatter
+char *stamp(char *out, uint64_t time_us)
+{
+    // use the wall-clock time once the timebase knows the RTC
+    if(timebase.anchored())
+        return Timebase::str(out, timebase.to_rtc_us(time_us));
+    // otherwise the time since boot
+    return Timebase::str(out, time_us);
+}
+
+// definition of the DMA block interrupt of the temperature sensor
+void adc_block_ready(void)
+{
+    // Remember when the block (and so its last reading) was completed
+    block_time = timebase.now_us();
+    // Set a signal that a block of conversions is ready to be decimated
+    read_temp_thread.signal_set(1);
+}
+
 // definition of temperature reading thread
 void read_temp(void)
-{   // thread loop
+{
+    // the readings of every zone decimated from a block of conversions
+    uint16_t readings[ADCDMA_MAX_OUTPUTS * ADCDMA_MAX_CHANNELS];
+    // the time and the period (us) of the previous reading, 0 if none
+    uint64_t previous = 0;
+    float previous_period = 0;
+    // the band of the thresholds the previous reading was in
+    int band = classifier.band();
+    // reject the readings that are too far from their zone's recent median
+    for(int z = 0; z < zones; z++)
+        spike_filters[z].set_mode(SPIKE_REJECT, spike_limit);
+    // the rate the sampler asked for last
+    float requested = temp_sensor.output_rate();
+    // wake this thread only when the DMA has completed a block
+    temp_sensor.attach(&adc_block_ready);
+    // convert in the quiet phase of the fan PWM (its period is set)
+    temp_sensor.sync_to_pwm(ADC_PWM_SYNC);
+    // start the timer-triggered conversions
+    temp_sensor.start();
+    // thread loop
     while(1) {
-        // Read the analog voltage to temperature reading
-        temp = temp_sensor * 100;
-        // Set a signal that the temperature has been read for avg to be calc.
-        temperature_average_thread.signal_set(1);
-        // Wait some time before reading the temperature again
-        Thread::wait(thread_wait_long);
+        // Wait for the DMA to fill a block; the CPU sleeps meanwhile
+        read_temp_thread.signal_wait(1);
+        // Take the time the block was completed at
+        uint64_t completed = block_time;
+        // The interval between two readings of this block in us
+        float period = 1000000 / temp_sensor.output_rate();
+        // Decimate the block into readings on the read_u16() scale
+        int count = temp_sensor.read(readings, ADCDMA_MAX_OUTPUTS);
+        // the topics of the hub this block brings
+        uint32_t topics = 0;
+        for(int i = 0; i < count; i++) {
+            // Each reading ends one period before the next one
+            TempSample sample;
+            sample.time_us = completed - (uint64_t)((count - 1 - i) * period);
+            // Convert the analog voltage of every zone to temperature reading
+            // using the sensor table of the zone, then drop the glitches
+            for(int z = 0; z < zones; z++)
+                zone_temp[z] = spike_filters[z].filter(
+                    zone_sensor[z](readings[i * zones + z]));
+            // Zone 0 is the reference temperature
+            temp = sample.value = zone_temp[0];
+            // Measure how far the interval from the previous reading is from
+            // the period, unless the rate changed in between
+            if(previous != 0 && previous_period == period) {
+                int32_t deviation = (int32_t)(sample.time_us - previous)
+                    - (int32_t)period;
+                if(deviation < 0)
+                    deviation = -deviation;
+                if((uint32_t)deviation > sample_jitter)
+                    sample_jitter = deviation;
+            }
+            previous = sample.time_us;
+            previous_period = period;
+            // The thresholds the temperature is classified against
+            centi_t limits[3] = { centi_from_deg(tempMin),
+                centi_from_deg(tempMid), centi_from_deg(tempMax) };
+            // Classify the reading, once for every output; it changes band
+            // when it crosses a threshold by more than BAND_HYSTERESIS
+            classifier.set_hysteresis(BAND_HYSTERESIS);
+            int now_band = classifier.classify(sample.value, limits, 3);
+            temp_zone = now_band;
+            // Publish the timestamped sample (and the crossing, if any)
+            sample_mutex.lock();
+            temp_sample = sample;
+            if(now_band != band) {
+                last_crossing.time_us = sample.time_us;
+                last_crossing.value = sample.value;
+                last_crossing.from = band;
+                last_crossing.to = now_band;
+            }
+            sample_mutex.unlock();
+            topics |= HUB_SAMPLE | (now_band != band ? HUB_BAND : 0);
+            band = now_band;
+            // Let the sampler choose the rate of the next readings, fast
+            // around the same thresholds
+            float rate = sampler.update(sample.time_us, temp, limits, 3);
+            // Reprogram the trigger timer only when the rate changed
+            if(rate != requested) {
+                temp_sensor.set_output_rate(rate);
+                requested = rate;
+            }
+            // Hand the reading of every zone over to the averaging thread
+            for(int z = 0; z < zones; z++) {
+                TempSample reading = { sample.time_us, zone_temp[z] };
+                zone_samples[z].push(reading);
+            }
+            // Set a signal that the temperature has been read for avg
+            // to be calc.
+            temperature_average_thread.signal_set(1);
+        }
+        // Wake the output threads that care about this block
+        if(topics)
+            hub.publish(topics);
     }
 
 }
@@ -642,98 +753,208 @@ void read_temp(void)
 // definiton of a thread to control the pulse width of the PWM output
 void pwm(void)
 {
-    // thread loop
+    // the band of the thresholds the output was last set for
+    int applied = -1;
+    // the duty (Q16) last written to the output
+    int32_t written = -1;
+    // the outputs_epoch the output was last set in
+    unsigned epoch = outputs_epoch;
+    // whether the output was held off for an emergency or a remote session
+    bool held = false;
+    // control loop, every CONTROL_PERIOD ms
     while(1) {
-        // if the temperature is less than the minimum temperature
-        if(temp < tempMin)
-            // turn of the PWM output
-            mypwm = 0;
-        // if the temperature is greater than the minimum temperature 
-        // but less than the medium temperature
-        else if (temp < tempMid)
-            // turn on the pwm at 30% 
-            mypwm = 0.3;
-        // if the temperature is greater than the medium temperature
-        // but less than the maximum temperature
-        else if (temp < tempMax)
-            // turn on the pwm at 60%
-            mypwm = 0.6;
-        // if the temperature is greater than the maximum temperature
-        else
-            // turn on fully the pwm
-            mypwm = 1;
-        // wait sometime before checking again for changes
-        // Let other threads before their work meanwhile (e.g. read temperature)
-        Thread::wait(thread_wait_long);
+        // the thresholds the temperature is classified against
+        centi_t limits[3] = { centi_from_deg(tempMin),
+            centi_from_deg(tempMid), centi_from_deg(tempMax) };
+        // the band of the latest reading, classified once by read_temp,
+        // or the higher band the trend reaches within PREARM_HORIZON
+        int band = fan_band(temp_zone, temp_forecast, limits, 3);
+        // the duty that brings zone 0 back to the medium temperature (the
+        // relay of an auto-tune meanwhile), full speed in the top band;
+        // the simulation of ThermalSim takes the same decisions
+        pid_mutex.lock();
+        int32_t duty = fan_duty(fan_pid, tuner, tune_rule, tuned_gains,
+            centi_from_deg(tempMid), temp, band, 3, CONTROL_PERIOD);
+        pid_mutex.unlock();
+        // an emergency or a remote session turned the outputs off, and
+        // may have given them back since
+        bool off = outputs_off[OFF_EMERGENCY] || outputs_off[OFF_REMOTE];
+        bool restore = epoch != outputs_epoch;
+        epoch = outputs_epoch;
+        if(off) {
+            // keep the fan off until the outputs are given back (once: a
+            // duty written as they were turned off is overwritten)
+            if(!held)
+                mypwm = 0;
+            held = true;
+        } else if(duty != written || restore || held) {
+            // write the output only when the duty changed, or to restore it
+            mypwm = duty / (float)PID_ONE;
+            written = duty;
+            held = false;
+            // keep the conversions in the off-period of the new duty
+            temp_sensor.follow_pwm();
+        }
+        // measure the speed of the fan over this period, and raise an
+        // emergency the moment it stalls; held off, it is not driven and
+        // may stop
+        bool stalled = fan_tach.stalled();
+        fan_tach.update(us_ticker_read(), held ? 0 : written);
+        if(fan_tach.stalled() && !stalled) {
+            fan_stalls++;
+            fan_stalled = true;
+            emergency_time = timebase.now_us();
+            emergency_thread.signal_set(1);
+        }
+        // if the output just reacted to a new band
+        if(band != applied) {
+            // measure the time since the reading that crossed into it
+            sample_mutex.lock();
+            ThresholdEvent crossing = last_crossing;
+            sample_mutex.unlock();
+            if(applied != -1 && crossing.to == band)
+                reaction_latency = (uint32_t)(timebase.now_us()
+                    - crossing.time_us);
+            applied = band;
+        }
+        // wait for the next control period
+        // Let other threads do their work meanwhile (e.g. read temperature)
+        Thread::wait(CONTROL_PERIOD);
     }
 }
 
 // definition for led thread that controls the 3 colored leds
 void led(void)
 {
+    // the band of the thresholds the leds were last set for
+    int applied = -1;
+    // the outputs_epoch the leds were last set in
+    unsigned epoch = outputs_epoch;
+    // whether the leds were held off for an emergency or a remote session
+    bool held = false;
     // thread loop
     while(1) {
-        // if the temperature is less than the minimum temperature
-        if(temp < tempMin) {
-            // turn on yellow only
-            green = 0;
-            yellow = 1;
-            red = 0;
-        // if the temperature is greater than the minimum temperature
-        // but less than the medium temperature
-        } else if(temp < tempMid) {
-            // turn on both green and yellow
-            green = 1;
-            yellow = 1;
-            red = 0;
-        // if the temperature is greater than the medium temperature
-        // but less than the maximum temperature
-        } else if(temp < tempMax) {
-            // turn on both green and red 
-            green = 1;
-            yellow = 0;
-            red = 1;
-        // if the temperature is even greater than the maximum temperature
-        } else {
-            // turn on red only
-            green = 0;
-            yellow = 0;
-            red = 1;
+        // the band of the latest reading, classified once by read_temp
+        int band = temp_zone;
+        if(outputs_off[OFF_EMERGENCY] || outputs_off[OFF_REMOTE]) {
+            // keep the leds off until the outputs are given back
+            if(!held) {
+                green = 0;
+                yellow = 0;
+                red = 0;
+            }
+            held = true;
+        } else if(band != applied || epoch != outputs_epoch || held) {
+            // write the leds only when the band changed, or to restore them
+            // yellow when cold, green and yellow when stable, green and red
+            // when high, red only when heated
+            green = band_green[band];
+            yellow = band_yellow[band];
+            red = band_red[band];
+            applied = band;
+            epoch = outputs_epoch;
+            held = false;
         }
-        // wait sometime before checking again for changes
-        // Let other threads before their work meanwhile (e.g. read temperature)
-        Thread::wait(thread_wait_long);
+        // sleep until a band change is published
+        // Let other threads do their work meanwhile (e.g. read temperature)
+        hub.wait(led_subscriber);
     }
 }
 
 // definition for uart thread that transmits the temperature information by uart
 void uart(void)
 {
+    // holds the temperature formatted without floating point
+    char value[CENTI_STR_SIZE];
     // thread while
     while(1) {
-        // if the temperature is less than the minimum temperature
-        if(temp < tempMin) {
-            // Display a message on the UART declaring the current state
-            pc.printf("Cold %fC\r\n", temp);
-        // if the temperature is greater than the minimum temperature
-        // but less than the medium temperature
-        } else if(temp < tempMid) {
-            // Display a message on the UART declaring the current state
-            pc.printf("Stable %fC\r\n", temp);
-        // if the temperature is greater than the medium temperature
-        // but less than the maximum temperature
-        } else if(temp < tempMax) {
-            // Display a message on the UART declaring the current state
-            pc.printf("High %fC\r\n", temp);
-        // if the temperature is even greater than the maximum temperature
-        } else {
-            // Display a message on the UART declaring the current state
-            pc.printf("Heated %fC\r\n", temp);
-
-        }
-        // wait sometime before checking again for changes
-        // Let other threads before their work meanwhile (e.g. read temperature)
-        Thread::wait(thread_wait_med);
+        // take a single copy of the temperature for this cycle
+        centi_t t = temp;
+        // format the temperature as degrees with two decimals
+        centi_str(value, t);
+        // Display a message on the UART declaring the current state
+        pc.printf("%s %sC\r\n", band_names[temp_zone], value);
+        // Display when the latest reading was taken, the sampling jitter
+        // and how long the fan took to react to the latest crossing
+        sample_mutex.lock();
+        uint64_t sampled = temp_sample.time_us;
+        sample_mutex.unlock();
+        char when[TIMEBASE_STR_SIZE];
+        pc.printf("  Sampled at %ss, jitter %lu us, reaction %lu us\r\n",
+            stamp(when, sampled), (unsigned long)sample_jitter,
+            (unsigned long)reaction_latency);
+        // Display the spread of the averaging window of zone 0
+        char low[CENTI_STR_SIZE], high[CENTI_STR_SIZE];
+        pc.printf("  Window: min %sC max %sC stddev %sC\r\n",
+            centi_str(low, averages[0].minimum()),
+            centi_str(high, averages[0].maximum()),
+            centi_str(value, averages[0].stddev()));
+        // Display the trend and when it reaches tempMax
+        pc.printf("  Trend: %sC/min, ", centi_str(value,
+            (centi_t)(trend.slope() * 60)));
+        int32_t eta = eta_max;
+        if(eta < 0)
+            pc.printf("not heading to tempMax\r\n");
+        else
+            pc.printf("tempMax in %ld s\r\n", (long)eta);
+        // Display the peaks of the last minute, hour and 2 days
+        history_mutex.lock();
+        HistoryBucket minute = history.summary(HISTORY_SECONDS, 60);
+        HistoryBucket hour = history.summary(HISTORY_MINUTES, 60);
+        HistoryBucket days = history.summary(HISTORY_HOURS, 48);
+        history_mutex.unlock();
+        pc.printf("  Peak: 1 min %sC", centi_str(value, minute.max));
+        pc.printf(", 1 h %sC", centi_str(value, hour.max));
+        pc.printf(", 48 h %sC (mean %sC)\r\n", centi_str(high, days.max),
+            centi_str(low, days.mean()));
+        // Display how many glitches were rejected on zone 0, and how many
+        // readings the averaging thread was too late to take
+        pc.printf("  Spikes rejected: %u, readings dropped: %lu\r\n",
+            spike_filters[0].rejected(),
+            (unsigned long)zone_samples[0].overflows());
+        // Display how long the latest reading took to reach the outputs,
+        // and how long the interval of the lcd then held it back
+        pc.printf("  Latency: leds %lu us (max %lu), lcd %lu us (max %lu)"
+            " + hold %lu ms\r\n",
+            (unsigned long)hub.latency(led_subscriber),
+            (unsigned long)hub.max_latency(led_subscriber),
+            (unsigned long)hub.latency(display_subscriber),
+            (unsigned long)hub.max_latency(display_subscriber),
+            (unsigned long)(hub.hold(display_subscriber) / 1000));
+        // Display the duty the fan controller asks for, the speed of the
+        // fan and how many times it stalled
+        pid_mutex.lock();
+        int32_t duty = fan_pid.output();
+        pid_mutex.unlock();
+        pc.printf("  Fan: %d.%d%%, %lu rpm, %u stalls\r\n",
+            (int)(duty * 1000LL / PID_ONE / 10),
+            (int)(duty * 1000LL / PID_ONE % 10),
+            (unsigned long)fan_tach.rpm(), fan_stalls);
+        // Display the progress or the result of the latest auto-tune
+        pid_mutex.lock();
+        TuneState tuning = tuner.state();
+        int cycles = tuner.cycles();
+        uint32_t period = tuner.period();
+        centi_t amplitude = tuner.amplitude();
+        pid_mutex.unlock();
+        if(tuning == TUNE_RUNNING)
+            pc.printf("  Auto-tune: cycle %d of %d\r\n", cycles + 1,
+                tuner.total());
+        else if(tuning == TUNE_DONE)
+            pc.printf("  Auto-tune: period %lu s, amplitude %sC\r\n",
+                (unsigned long)(period / 1000), centi_str(value, amplitude));
+        else if(tuning == TUNE_FAILED)
+            pc.printf("  Auto-tune: failed, gains unchanged\r\n");
+        // Display the current sampling rate and how often it changed
+        pc.printf("  Sampling: %d mHz, %u rate switches\r\n",
+            (int)(sampler.rate() * 1000), sampler.switches());
+        // Display the temperature of the other zones, if any
+        for(int z = 1; z < zones; z++)
+            pc.printf("  Zone %d: %sC\r\n", z,
+                centi_str(value, zone_temp[z]));
+        // sleep until a new reading, at most every thread_wait_med is published
+        // Let other threads do their work meanwhile (e.g. read temperature)
+        hub.wait(uart_subscriber);
     }
 
 }
@@ -744,42 +965,119 @@ void display_temp(void)
     // thread loop
     while(1) {
         // Relocate the lcd to its origin
-        lcd.locate(0,0);
+        status.locate(0,0);
         // Display the temperature along with the average temperature
-        lcd.printf("T: %3.0fC TA: %3.0fC", temp, temp_avg);
-        // Wait sometime before displaying the new values
-        Thread::wait(thread_wait_long);
+        status.printf("T: %3dC TA: %3dC", centi_round(temp),
+            centi_round(temp_avg));
+        // Display the trend and the duty of the fan, or how long before
+        // tempMax is reached at the current trend, or the progress of an
+        // auto-tune
+        status.locate(0,1);
+        int32_t eta = eta_max;
+        pid_mutex.lock();
+        bool tuning = tuner.state() == TUNE_RUNNING;
+        int cycle = tuner.cycles() + 1;
+        pid_mutex.unlock();
+        if(tuning)
+            status.printf("Auto-tune %d/%d   ", cycle, tuner.total());
+        else if(LCD_GRAPHS) {
+            // the mean of each of the last minutes, the oldest first
+            HistoryBucket minutes[SPARK_CELLS];
+            history_mutex.lock();
+            for(int i = 0; i < SPARK_CELLS; i++)
+                minutes[i] = history.bucket(HISTORY_MINUTES,
+                    SPARK_CELLS - 1 - i);
+            history_mutex.unlock();
+            sparkline(status, minutes, SPARK_CELLS);
+            status.putc(' ');
+            // the duty the fan is driven at
+            bar(status, mypwm.read(), DUTY_CELLS);
+        } else if(eta < 0)
+            status.printf("Max: not rising ");
+        else
+            status.printf("Max in %6lds  ", (long)eta);
+        // Wait for a new reading or average, at most every thread_wait_short
+        hub.wait(display_subscriber);
     }
 }
 
-// This thread calculates the average temperature of the last ten values
+// This thread calculates the average temperature of the last
+// AVERAGE_WINDOW values
 void temperature_average(void)
 {
     // thread loop
     while(1) {
         // make sure that a new value of the temperature has been read before
-        // calculating the average
+        // calculating the average; one signal may stand for many readings
         temperature_average_thread.signal_wait(1);
-        // add the current temperature reading to the queue
-        // in case the queue already holds ten elements, replace the oldest
-        averages.enqueue(temp);
-        // save the value of the average
-        temp_avg = averages.average();
+        // for every zone
+        for(int z = 0; z < zones; z++) {
+            // take every reading waiting in the zone's channel, exactly once
+            TempSample reading;
+            centi_t block[SMOOTH_BLOCK];
+            int count = 0;
+            while(count < SMOOTH_BLOCK && zone_samples[z].pop(reading)) {
+                block[count++] = reading.value;
+                // add the temperature reading to the zone's queue
+                // in case the queue already holds AVERAGE_WINDOW elements,
+                // replace the oldest
+                averages[z].enqueue(reading.value);
+                // Record zone 0 in the seconds/minutes/hours history
+                if(z == 0) {
+                    history_mutex.lock();
+                    history.add(reading.time_us, reading.value);
+                    percentiles.add(reading.time_us, reading.value);
+                    history_mutex.unlock();
+                    // follow the trend of zone 0
+                    trend.update(reading.time_us, reading.value);
+                }
+            }
+            // nothing new for this zone
+            if(count == 0)
+                continue;
+            // predict where zone 0 is heading
+            if(z == 0) {
+                temp_forecast = trend.forecast(PREARM_HORIZON);
+                float eta = trend.eta(centi_from_deg(tempMax));
+                eta_max = eta < 0 ? -1 : (int32_t)(eta + 0.5f);
+            }
+            // filter the new readings as one block
+            smoothers[z].process(block, block, count);
+            // save the value of the average, or of the selected filter
+            if(smoothers[z].mode() == SMOOTH_BOXCAR)
+                zone_avg[z] = averages[z].average();
+            else
+                zone_avg[z] = block[count - 1];
+            // come back for the readings that did not fit in the block
+            if(!zone_samples[z].empty())
+                temperature_average_thread.signal_set(1);
+        }
+        // Zone 0 is the reference average temperature
+        temp_avg = zone_avg[0];
+        // Wake the threads showing the averages and using the forecast
+        hub.publish(HUB_AVERAGE);
     }
 }
 
+// Definition of the LCD render thread
+void lcd_render(void)
+{
+    // render the layer on top whenever it changes
+    screen.run();
+}
+
 // Definition of the emergency line flasher 
 void flash_emergency_message(bool &exclamation)
 {
     // Relocate the lcd screen to its origin
-    lcd.locate(0,0);
+    alert.locate(0,0);
     // If last time exclamations were used in the message, hide them
     if(exclamation)
         // display emergency statement on the lcd screen
-        lcd.printf("   EMERGENCY    ");
+        alert.printf("   EMERGENCY    ");
     else
         // display emergency statement on the lcd screen with exclamations
-        lcd.printf("!! EMERGENCY !! ");
+        alert.printf("!! EMERGENCY !! ");
     // indicate whether exlamations were used this time in the message or not
     exclamation = !exclamation;
 }
@@ -796,13 +1094,26 @@ void emergency(void)
     while(1) {
         // wait for the conditions of this emergency process to take place
         emergency_thread.signal_wait(1);
+        // Display a message on the UART with the cause and the time of the
+        // trigger and how long it took for this thread to handle it
+        uint64_t triggered = emergency_time;
+        char when[TIMEBASE_STR_SIZE];
+        pc.printf(" Emergency (%s) triggered at %ss, handled after %lu us\r\n",
+            fan_stalled ? "fan stalled" : "user", stamp(when, triggered),
+            (unsigned long)(timebase.now_us() - triggered));
+        fan_stalled = false;
+        // cover whatever is on the screen with the emergency layer
+        alert.show();
         // reset the timer back to zero to start timing the duration
         t.reset();
-        // turn off all outputs
+        // turn off all outputs, and keep the pwm and led threads from
+        // turning them back on until the timeout
+        outputs_off[OFF_EMERGENCY] = true;
         mypwm = 0;
         red = 0;
         yellow = 0;
         green = 0;
+        hub.publish(HUB_BAND);
         // start the timer
         t.start();
         // keep looping until the time waited have met the timeout duration
@@ -810,11 +1121,11 @@ void emergency(void)
             // meanwhile, flash the emergency statement
             flash_emergency_message(exclamation);
             // relocate the lcd back to the origin
-            lcd.locate(0,1);
+            alert.locate(0,1);
             // print the time left to go back to normal state on the lcd screen
-            lcd.printf("Back In: %2d     ", TIMEOUT - (int)(t.read())  );
+            alert.printf("Back In: %2d     ", TIMEOUT - (int)(t.read())  );
             // Display a message on the UART declaring the current state
-            pc.printf(" Emergency: timer = %f\r\n", t.read());
+            pc.printf(" Emergency: timer = %d ms\r\n", t.read_ms());
             // wait for sometime before checking again if the duration is met,
             // and before changing the exclamation message again
             wait_ms(200);
@@ -825,9 +1136,15 @@ void emergency(void)
         // this gives the user enough time to know that time is up
         wait_ms(1000);
         // clear the lcd from the previous values
-        lcd.cls();
+        alert.cls();
         // keep the screen off for some time
         wait_ms(100);
+        // give the screen back to the layers below
+        alert.hide();
+        // give the outputs back to the pwm and led threads
+        outputs_off[OFF_EMERGENCY] = false;
+        outputs_epoch++;
+        hub.publish(HUB_BAND);
         // clear the signal so that we can detect new signals
         emergency_thread.signal_clr(1);
     }
@@ -1101,6 +1418,154 @@ void modify_timer(void)
 
 }
 
+// Definition of the smoothing selection of the remote session
+void modify_smoothing(void)
+{
+    // Display the available smoothing modes
+    pc.printf("Select the smoothing of the average temperature:\n\r"
+        "0. Average of the last %d readings\n\r"
+        "1. Exponential moving average (1/8)\n\r"
+        "2. Single-pole low-pass (0.05 x reading rate)\n\r"
+        "3. 4th order Butterworth low-pass (0.05 x reading rate)\n\r",
+        AVERAGE_WINDOW);
+    // Wait for the user to enter one of the given options
+    char c = 0;
+    while(c < '0' || c > '3')
+        c = pc.getc();
+    // Build the selected filter
+    SmoothConfig config;
+    if(c == '0')
+        config = Smoother::boxcar();
+    else if(c == '1')
+        config = Smoother::ema(3);
+    else if(c == '2')
+        config = Smoother::one_pole(0.05f);
+    else
+        config = Smoother::lowpass(0.05f, 2);
+    // Hand it to every zone; the sampling keeps running, and a zone that
+    // has not taken its previous filter yet is retried
+    for(int z = 0; z < zones; z++)
+        while(!smoothers[z].configure(config))
+            Thread::wait(10);
+    // Display a message on the UART declaring the current state
+    pc.printf("Smoothing changed to option %c\n\r", c);
+}
+
+// Definition of the number input of the remote session
+int read_number(void)
+{
+    // The character limits of the input
+    const int char_limit = 8;
+    // the array that will hold the input of the user
+    char user[char_limit + 1];
+    // the index of the array
+    int i = 0;
+    // get the first character from the terminal
+    char c = pc.getc();
+    // keep looping until the character is space or enter
+    while(c != '\n' && c != '\r' && c != ' ') {
+        // if the character is backspace and there is a character previously
+        // entered, erase it on the terminal
+        if(c == '\b' && i != 0) {
+            i--;
+            pc.printf("\b \b");
+        // if the character is numeric and within the limit, keep it
+        } else if(c >= '0' && c <= '9' && i < char_limit) {
+            user[i++] = c;
+            pc.putc(c);
+        }
+        // fetch the next character from the terminal
+        c = pc.getc();
+    }
+    pc.printf("\n\r");
+    // Add the end of string and convert it
+    user[i] = '\0';
+    return atoi(user);
+}
+
+// Converts a gain in thousandths of the duty to the Q16 of FanPid
+static int32_t gain_from_permille(int permille)
+{
+    return (int32_t)(((int64_t)permille * PID_ONE + 500) / 1000);
+}
+
+// Converts a Q16 gain of FanPid to thousandths of the duty
+static int gain_to_permille(int32_t gain)
+{
+    return (int)(((int64_t)gain * 1000 + PID_ONE / 2) / PID_ONE);
+}
+
+// Definition of the fan controller settings of the remote session
+void modify_controller(void)
+{
+    // Display the current settings
+    pc.printf("Fan controller (duty in 1/1000 per degree C):\n\r");
+    pid_mutex.lock();
+    PidGains gains = fan_pid.gains();
+    pid_mutex.unlock();
+    pc.printf("Kp = %d, Ki = %d per second, Kd = %d x second, "
+        "period = %d ms\n\r", gain_to_permille(gains.kp),
+        gain_to_permille(gains.ki), gain_to_permille(gains.kd),
+        CONTROL_PERIOD);
+    // Ask for the new ones
+    pc.printf("Enter new Kp: ");
+    gains.kp = gain_from_permille(read_number());
+    pc.printf("Enter new Ki: ");
+    gains.ki = gain_from_permille(read_number());
+    pc.printf("Enter new Kd: ");
+    gains.kd = gain_from_permille(read_number());
+    pc.printf("Enter new control period (ms): ");
+    int period = read_number();
+    // Apply them to the running controller
+    pid_mutex.lock();
+    fan_pid.set_gains(gains);
+    if(period > 0)
+        CONTROL_PERIOD = period;
+    pid_mutex.unlock();
+    // Display a message on the UART declaring the current state
+    pc.printf("Fan controller changed\n\r");
+}
+
+// Definition of the auto-tune of the remote session
+void autotune_controller(void)
+{
+    // Display the result of the latest auto-tune, if any
+    pid_mutex.lock();
+    TuneState state = tuner.state();
+    uint32_t period = tuner.period();
+    PidGains gains = tuned_gains;
+    pid_mutex.unlock();
+    if(state == TUNE_DONE)
+        pc.printf("Latest auto-tune: period %lu s, Kp = %d, Ki = %d, "
+            "Kd = %d\n\r", (unsigned long)(period / 1000),
+            gain_to_permille(gains.kp), gain_to_permille(gains.ki),
+            gain_to_permille(gains.kd));
+    // Display the available rules
+    pc.printf("Auto-tune the fan controller around TempMid (%dC):\n\r"
+        "0. Cancel a running auto-tune\n\r"
+        "1. Ziegler-Nichols (fast)\n\r"
+        "2. Tyreus-Luyben (less overshoot)\n\r", tempMid);
+    // Wait for the user to enter one of the given options
+    char c = 0;
+    while(c < '0' || c > '2')
+        c = pc.getc();
+    // Start the relay experiment; the pwm thread runs it and applies the
+    // gains once the oscillation is measured
+    pid_mutex.lock();
+    if(c == '0')
+        tuner.stop();
+    else {
+        tune_rule = c == '1' ? TUNE_ZIEGLER_NICHOLS : TUNE_TYREUS_LUYBEN;
+        tuner.start(centi_from_deg(tempMid));
+    }
+    pid_mutex.unlock();
+    // Display a message on the UART declaring the current state
+    if(c == '0')
+        pc.printf("Auto-tune cancelled\n\r");
+    else
+        pc.printf("Auto-tune started, progress is on the LCD\n\r");
+}
+
 // Definition of remote session thread
 void remote_session(void)
 {
@@ -1108,11 +1573,14 @@ void remote_session(void)
     while(1) {
         // Wait for the conditions of this emergency process to take place
         remote_session_thread.signal_wait(1);
-        // Turn off all the outputs
+        // Turn off all the outputs, and keep the pwm and led threads from
+        // turning them back on until the session ends
+        outputs_off[OFF_REMOTE] = true;
         yellow = 0;
         green = 0;
         red = 0;
         mypwm = 0;
+        hub.publish(HUB_BAND);
         // Character c stores the input of the user
         char c = 0;
         // Keep looping until the user terminates the session
@@ -1134,9 +1602,15 @@ void remote_session(void)
             pc.printf("3. Modify Emergency Timer Value\n\r");
             // Display a message on the UART explaining the fourth option
             pc.printf("4. Terminate Session\n\r");
+            // Display a message on the UART explaining the fifth option
+            pc.printf("5. Select Temperature Smoothing\n\r");
+            // Display a message on the UART explaining the sixth option
+            pc.printf("6. Modify Fan Controller Gains\n\r");
+            // Display a message on the UART explaining the seventh option
+            pc.printf("7. Auto-tune Fan Controller\n\r");
             
             // Wait for the user to enter one of the given options
-            while(c != '1' && c != '2' && c != '3' && c != '4')
+            while(c < '1' || c > '7')
             // Read the input from the user
                 c = pc.getc();
             // If the user choose the first option
@@ -1156,15 +1630,85 @@ void remote_session(void)
                 // Display a message indicating that the session is over
                 // before exiting
                 pc.printf("Terminating\n\r");
+            // If the user choose the fifth option
+            if(c == '5')
+                // select the smoothing of the average temperature
+                modify_smoothing();
+            // If the user choose the sixth option
+            if(c == '6')
+                // modify the gains of the fan controller
+                modify_controller();
+            // If the user choose the seventh option
+            if(c == '7')
+                // auto-tune the gains of the fan controller
+                autotune_controller();
 
         }// c != 4/
+        // give the outputs back to the pwm and led threads
+        outputs_off[OFF_REMOTE] = false;
+        outputs_epoch++;
+        hub.publish(HUB_BAND);
 
     } // while true/
 } // remote_session/
 
+// Prints one percentile summary line of the export block
+static void print_summary(const char *name, const HistogramSummary &s)
+{
+    char from[TIMEBASE_STR_SIZE], to[TIMEBASE_STR_SIZE];
+    char p50[CENTI_STR_SIZE], p95[CENTI_STR_SIZE], p99[CENTI_STR_SIZE];
+    char max[CENTI_STR_SIZE];
+    pc.printf("%s %s %s n=%lu p50=%s p95=%s p99=%s max=%s\r\n", name,
+        stamp(from, s.start_us), stamp(to, s.end_us),
+        (unsigned long)s.count, centi_str(p50, s.p50),
+        centi_str(p95, s.p95), centi_str(p99, s.p99), centi_str(max, s.max));
+}
+
+// Definition of the percentile export
+void print_percentiles(void)
+{
+    // Take the summaries of a single moment, then print them without
+    // holding the averaging thread up for the seconds the UART takes
+    history_mutex.lock();
+    HistogramSummary current = percentiles.summary(timebase.now_us());
+    HistogramSummary last = percentiles.last();
+    history_mutex.unlock();
+    print_summary("PCT", current);
+    print_summary("LAST", last);
+    // The bins: the lowest temperature and width, then index:count pairs,
+    // 10 a line. Each line is read under the lock and printed after it,
+    // so only a line is copied; readings counted meanwhile show in the
+    // lines not printed yet, and the export stops if the period ends.
+    pc.printf("BINS %d %d", (int)percentiles.bin_low(0),
+        (int)(percentiles.bin_low(1) - percentiles.bin_low(0)));
+    int next = 0;
+    while(next < percentiles.BINS) {
+        int index[10];
+        uint32_t count[10];
+        int pairs = 0;
+        history_mutex.lock();
+        if(percentiles.last().end_us != last.end_us) {
+            history_mutex.unlock();
+            break;
+        }
+        for(; next < percentiles.BINS && pairs < 10; next++)
+            if(percentiles.bin(next) != 0) {
+                index[pairs] = next;
+                count[pairs++] = percentiles.bin(next);
+            }
+        history_mutex.unlock();
+        for(int i = 0; i < pairs; i++)
+            pc.printf(i ? " %d:%lu" : "\r\n%d:%lu", index[i],
+                (unsigned long)count[i]);
+    }
+    pc.printf("\r\nEND\r\n");
+}
+
 // Definition of emergency button interrupt
 void emerg_thread_activation(void)
 {   
+    // Remember when the emergency was triggered
+    emergency_time = timebase.now_us();
     // Send a signal for the emergency thread to resume
     emergency_thread.signal_set(1);
 }
@@ -1203,12 +1747,25 @@ void keyboard_input(void)
         pc.printf("Entered keyboard input: %c\n\r", c);
         // If the input is E
         if(c == 'E' || c == 'e') {
+            // Remember when the emergency was triggered
+            emergency_time = timebase.now_us();
             // enable the emergency thread
             emergency_thread.signal_set(1);
         // If the input is R
         } else if (c == 'R' || c == 'r') {
             // enable the remote session thread
             remote_session_thread.signal_set(1);
+        // If the input is P
+        } else if (c == 'P' || c == 'p') {
+            // export the percentiles of the current and the last period
+            print_percentiles();
+        // If the input is Z
+        } else if (c == 'Z' || c == 'z') {
+            // start a new percentile period now
+            history_mutex.lock();
+            percentiles.reset(timebase.now_us());
+            history_mutex.unlock();
+            pc.printf("Percentiles reset\n\r");
         }
     }
 
@@ -1217,10 +1774,22 @@ void keyboard_input(void)
 // Definition of the main function of the program
 int main()
 {
+    // Start the 64-bit clock that stamps the samples and the events
+    timebase.start();
+    // Use the wall-clock time in the timestamps if the RTC was set
+    timebase.anchor_rtc();
     // Clear the LCD screen
     lcd.cls();
     // Relocate the lcd screen back to the origin
     lcd.locate(0,0);
+    // From now on the LCD writes return at once and a timer sends them
+    lcd.async(true);
+    // Only the render thread writes to the LCD from now on; it preempts the
+    // prompts, which busy-wait on the keypad at a high priority
+    lcd_thread.start(lcd_render);
+    lcd_thread.set_priority(osPriorityRealtime);
+    // Set the period of the fan PWM before the conversions follow it
+    mypwm.period_us(PWM_PERIOD_US);
     // Enable the pullups of the inputs
     c0.mode(PullUp);
     c1.mode(PullUp);
@@ -1236,6 +1805,14 @@ int main()
     init_mode_thread.start(init_mode);
     // Again, give it a high priority to perform it before the rest
     init_mode_thread.set_priority(osPriorityAboveNormal);
+    // Subscribe the output threads to the readings they act on: the leds
+    // only band changes, the UART and the LCD rate-limited (the fan runs
+    // its own control loop)
+    led_subscriber = hub.subscribe(led_thread, HUB_SIGNAL, HUB_BAND);
+    uart_subscriber = hub.subscribe(uart_thread, HUB_SIGNAL,
+        HUB_SAMPLE | HUB_BAND, thread_wait_med);
+    display_subscriber = hub.subscribe(display_temp_thread, HUB_SIGNAL,
+        HUB_SAMPLE | HUB_AVERAGE, thread_wait_short);
     // Then enable to threads that will perform in the round-robin
     read_temp_thread.start(read_temp);
     display_temp_thread.start(display_temp);